@@ -29,7 +29,7 @@ bool CAudio::Initialise()
 // Load an event sound
 bool CAudio::LoadEventSound(char *filename)
 {
-	result = m_FmodSystem->createSound(filename, NULL, 0, &m_eventSound);
+	result = m_FmodSystem->createSound(PlatformPath(filename).c_str(), NULL, 0, &m_eventSound);
 	FmodErrorCheck(result);
 	if (result != FMOD_OK) 
 		return false;
@@ -53,7 +53,7 @@ bool CAudio::PlayEventSound()
 // Load a music stream
 bool CAudio::LoadMusicStream(char *filename)
 {
-	result = m_FmodSystem->createStream(filename, NULL | FMOD_LOOP_NORMAL, 0, &m_music);
+	result = m_FmodSystem->createStream(PlatformPath(filename).c_str(), NULL | FMOD_LOOP_NORMAL, 0, &m_music);
 	FmodErrorCheck(result);
 
 	if (result != FMOD_OK) 
@@ -1,5 +1,5 @@
 #pragma once
-#include <windows.h>									// Header File For The Windows Library
+#include "Platform.h"
 #include "./include/fmod_studio/fmod.hpp"
 #include "./include/fmod_studio/fmod_errors.h"
 
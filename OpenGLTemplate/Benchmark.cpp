@@ -0,0 +1,1124 @@
+#include "Benchmark.h"
+#include "HighResolutionTimer.h"
+#include "CCatmullRom.h"
+#include "SplineCursor.h"
+#include "Parallel.h"
+#include "RingIndex.h"
+#include "EntityStore.h"
+#include "Collision.h"
+#include "Placement.h"
+#include "FramePacer.h"
+#include <iomanip>
+#include <float.h>
+
+// Generate a closed, gently undulating loop of numControlPoints points spaced roughly spacing units apart
+static void MakeBenchmarkTrack(int numControlPoints, float spacing, vector<glm::vec3> &controlPoints)
+{
+	float radius = numControlPoints * spacing / (2.0f * (float)M_PI);
+
+	controlPoints.clear();
+	controlPoints.reserve(numControlPoints);
+	for (int i = 0; i < numControlPoints; i++) {
+		float angle = 2.0f * (float)M_PI * i / numControlPoints;
+		float wobble = 1.0f + 0.1f * sinf(7.0f * angle);
+		controlPoints.push_back(glm::vec3(radius * wobble * cosf(angle), 5.0f * sinf(3.0f * angle), radius * wobble * sinf(angle)));
+	}
+}
+
+// Upvectors that bank the track from side to side, so the upvector interpolation is exercised too
+static void MakeBenchmarkUpVectors(int numControlPoints, vector<glm::vec3> &upVectors)
+{
+	upVectors.clear();
+	upVectors.reserve(numControlPoints);
+	for (int i = 0; i < numControlPoints; i++) {
+		float bank = 0.3f * sinf(2.0f * (float)M_PI * 5.0f * i / numControlPoints);
+		upVectors.push_back(glm::vec3(sinf(bank), cosf(bank), 0.0f));
+	}
+}
+
+// Generate a stadium shaped loop: two straights of straightLength joined by hairpins of the given radius, with control points 
+// roughly spacing units apart
+static void MakeBenchmarkStadium(float straightLength, float radius, float spacing, vector<glm::vec3> &controlPoints)
+{
+	int numStraight = (int)(straightLength / spacing);
+	int numBend = (int)((float)M_PI * radius / spacing);
+
+	controlPoints.clear();
+	for (int side = 0; side < 2; side++) {
+		float sign = side == 0 ? 1.0f : -1.0f;
+		for (int i = 0; i < numStraight; i++)
+			controlPoints.push_back(glm::vec3(sign * (-0.5f * straightLength + straightLength * i / numStraight), 0.0f, -sign * radius));
+		for (int i = 0; i < numBend; i++) {
+			float angle = (float)M_PI * i / numBend;
+			controlPoints.push_back(glm::vec3(sign * (0.5f * straightLength + radius * sinf(angle)), 0.0f, -sign * radius * cosf(angle)));
+		}
+	}
+}
+
+// Largest distance between the centreline and the polyline through the tessellated centreline points, measured every 0.25 units
+static float MaxTessellationError(const CCatmullRom &spline)
+{
+	const vector<glm::vec3> &points = spline.m_centrelinePoints;
+	const vector<float> &distances = spline.m_centrelineDistances;
+	float fTotalLength = spline.GetTotalLength();
+	int M = (int)points.size();
+
+	float maxError = 0.0f;
+	int i = 0;
+	glm::vec3 p, up;
+	for (float d = 0.0f; d < fTotalLength; d += 0.25f) {
+		while (i + 1 < M && distances[i + 1] <= d)
+			i++;
+		float fEnd = i + 1 < M ? distances[i + 1] : fTotalLength;
+		glm::vec3 q = glm::mix(points[i], points[(i + 1) % M], (d - distances[i]) / (fEnd - distances[i]));
+		spline.Sample(d, p, up);
+		maxError = glm::max(maxError, glm::length(p - q));
+	}
+	return maxError;
+}
+
+void RunBenchmarks(std::ostream &out)
+{
+	BenchmarkSplineSample(out);
+	BenchmarkSplineSampleBatch(out);
+	BenchmarkSplineCursor(out);
+	BenchmarkTessellation(out);
+	BenchmarkTrackCulling(out);
+	BenchmarkTrackEditing(out);
+	BenchmarkTrackProjection(out);
+	BenchmarkTrackBuild(out);
+	BenchmarkParameterization(out);
+	BenchmarkRingBroadphase(out);
+	BenchmarkEntityStore(out);
+	BenchmarkSweptCollision(out);
+	BenchmarkPlacement(out);
+	BenchmarkFramePacer(out);
+	BenchmarkJobSystem(out);
+}
+
+void BenchmarkSplineSample(std::ostream &out)
+{
+	const int numQueries = 1000000;
+	const int trackSizes[] = { 8, 64, 512, 4096, 32768, 262144 };
+
+	out << "CCatmullRom::Sample" << std::endl;
+	out << std::setw(16) << "control points" << std::setw(16) << "track length" << std::setw(20) << "samples/second" << std::endl;
+
+	CHighResolutionTimer timer;
+	vector<glm::vec3> controlPoints;
+	vector<glm::vec3> noUpVectors;
+	vector<float> queries(numQueries);
+
+	for (int s = 0; s < (int)(sizeof(trackSizes) / sizeof(trackSizes[0])); s++) {
+		MakeBenchmarkTrack(trackSizes[s], 3.0f, controlPoints);
+
+		CCatmullRom spline;
+		spline.SetControlPoints(controlPoints, noUpVectors);
+		float fTotalLength = spline.GetTotalLength();
+
+		// Random distances, so that the benchmark measures the segment search rather than cache locality along the track
+		srand(1234);
+		for (int i = 0; i < numQueries; i++)
+			queries[i] = fTotalLength * ((float)rand() / (RAND_MAX + 1.0f));
+
+		glm::vec3 p, up;
+		glm::vec3 checksum(0.0f);
+		timer.Start();
+		for (int i = 0; i < numQueries; i++) {
+			spline.Sample(queries[i], p, up);
+			checksum += p;
+		}
+		double ms = timer.Elapsed();
+
+		out << std::setw(16) << trackSizes[s] << std::setw(16) << std::fixed << std::setprecision(0) << fTotalLength
+			<< std::setw(20) << std::setprecision(0) << numQueries / (ms / 1000.0)
+			<< "   (checksum " << std::setprecision(2) << checksum.x + checksum.y + checksum.z << ")" << std::endl;
+	}
+	out << std::endl;
+}
+
+void BenchmarkSplineSampleBatch(std::ostream &out)
+{
+	const int numControlPoints = 4096;
+	const int numQueries = 1000000;
+
+	vector<glm::vec3> controlPoints, upVectors;
+	MakeBenchmarkTrack(numControlPoints, 3.0f, controlPoints);
+	MakeBenchmarkUpVectors(numControlPoints, upVectors);
+
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, upVectors);
+
+	// Evenly spread distances over two laps, as when placing objects along the whole track
+	vector<float> queries(numQueries);
+	for (int i = 0; i < numQueries; i++)
+		queries[i] = 2.0f * spline.GetTotalLength() * i / numQueries;
+
+	CHighResolutionTimer timer;
+
+	// Reference: one Sample call per distance
+	vector<glm::vec3> points(numQueries), ups(numQueries);
+	timer.Start();
+	for (int i = 0; i < numQueries; i++)
+		spline.Sample(queries[i], points[i], ups[i]);
+	double msSample = timer.Elapsed();
+
+	// Batched, positions and upvectors only to match what Sample returns
+	vector<float> px(numQueries), py(numQueries), pz(numQueries);
+	vector<float> tx(numQueries), ty(numQueries), tz(numQueries);
+	vector<float> ux(numQueries), uy(numQueries), uz(numQueries);
+	SplineBatchOutput batch;
+	batch.px = &px[0]; batch.py = &py[0]; batch.pz = &pz[0];
+	batch.ux = &ux[0]; batch.uy = &uy[0]; batch.uz = &uz[0];
+	timer.Start();
+	spline.SampleBatch(&queries[0], numQueries, batch);
+	double msBatch = timer.Elapsed();
+
+	// Batched, with tangents as well
+	batch.tx = &tx[0]; batch.ty = &ty[0]; batch.tz = &tz[0];
+	timer.Start();
+	spline.SampleBatch(&queries[0], numQueries, batch);
+	double msBatchTangents = timer.Elapsed();
+
+	float maxPositionError = 0.0f, maxUpError = 0.0f;
+	for (int i = 0; i < numQueries; i++) {
+		glm::vec3 p(px[i], py[i], pz[i]);
+		glm::vec3 up(ux[i], uy[i], uz[i]);
+		maxPositionError = glm::max(maxPositionError, glm::length(p - points[i]) / (1.0f + glm::length(points[i])));
+		maxUpError = glm::max(maxUpError, glm::length(up - ups[i]));
+	}
+
+	out << "CCatmullRom::SampleBatch (" << numControlPoints << " control points, " << numQueries << " samples)" << std::endl;
+	out << std::fixed << std::setprecision(0);
+	out << std::setw(32) << "Sample loop" << std::setw(16) << numQueries / (msSample / 1000.0) << " samples/second" << std::endl;
+	out << std::setw(32) << "SampleBatch" << std::setw(16) << numQueries / (msBatch / 1000.0) << " samples/second" << std::endl;
+	out << std::setw(32) << "SampleBatch with tangents" << std::setw(16) << numQueries / (msBatchTangents / 1000.0) << " samples/second" << std::endl;
+	out << std::scientific << std::setprecision(2);
+	out << "  max relative position difference " << maxPositionError << ", max upvector difference " << maxUpError << std::endl;
+	out << std::endl;
+}
+
+void BenchmarkSplineCursor(std::ostream &out)
+{
+	const int numControlPoints = 262144;
+	const int numQueries = 2000000;
+
+	vector<glm::vec3> controlPoints, noUpVectors;
+	MakeBenchmarkTrack(numControlPoints, 3.0f, controlPoints);
+
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, noUpVectors);
+
+	// Creep forward over a little more than one lap, so the wrap-around is included
+	float fStep = 1.1f * spline.GetTotalLength() / numQueries;
+
+	CHighResolutionTimer timer;
+	glm::vec3 p, checksumSample(0.0f), checksumCursor(0.0f);
+
+	timer.Start();
+	for (int i = 0; i < numQueries; i++) {
+		spline.Sample(i * fStep, p);
+		checksumSample += p;
+	}
+	double msSample = timer.Elapsed();
+
+	CSplineCursor cursor(&spline);
+	timer.Start();
+	for (int i = 0; i < numQueries; i++) {
+		cursor.Sample(i * fStep, p);
+		checksumCursor += p;
+	}
+	double msCursor = timer.Elapsed();
+
+	out << "CSplineCursor (" << numControlPoints << " control points, " << numQueries << " forward steps)" << std::endl;
+	out << std::fixed << std::setprecision(0);
+	out << std::setw(32) << "CCatmullRom::Sample" << std::setw(16) << numQueries / (msSample / 1000.0) << " samples/second" << std::endl;
+	out << std::setw(32) << "CSplineCursor::Sample" << std::setw(16) << numQueries / (msCursor / 1000.0) << " samples/second" << std::endl;
+	out << std::setprecision(4) << "  checksum difference " << glm::length(checksumSample - checksumCursor) << std::endl;
+	out << std::endl;
+}
+
+void BenchmarkTessellation(std::ostream &out)
+{
+	struct Setting { const char *name; bool adaptive; float maxAngle, maxChordError, maxSpacing; };
+	const Setting settings[] = {
+		{ "uniform, 2 units", false, 0.0f, 0.0f, 2.0f },
+		{ "adaptive 5 deg, 0.1", true, 5.0f, 0.1f, 20.0f },
+		{ "adaptive 2 deg, 0.02", true, 2.0f, 0.02f, 20.0f },
+		{ "adaptive 1 deg, 0.005", true, 1.0f, 0.005f, 20.0f },
+	};
+	const float straightLengths[] = { 200.0f, 2000.0f };
+
+	CHighResolutionTimer timer;
+	vector<glm::vec3> controlPoints, noUpVectors;
+
+	out << "Track tessellation (stadium with 40 unit hairpins)" << std::endl;
+	out << std::setw(12) << "straights" << std::setw(24) << "setting" << std::setw(14) << "centreline" << std::setw(16) << "track vertices"
+		<< std::setw(12) << "max error" << std::setw(12) << "ms" << std::endl;
+
+	for (int t = 0; t < (int)(sizeof(straightLengths) / sizeof(straightLengths[0])); t++) {
+		MakeBenchmarkStadium(straightLengths[t], 40.0f, 10.0f, controlPoints);
+
+		CCatmullRom spline;
+		spline.SetControlPoints(controlPoints, noUpVectors);
+
+		for (int s = 0; s < (int)(sizeof(settings) / sizeof(settings[0])); s++) {
+			const Setting &setting = settings[s];
+			if (setting.adaptive)
+				spline.SetAdaptiveTessellation(setting.maxAngle, setting.maxChordError, setting.maxSpacing);
+			else
+				spline.SetUniformTessellation((int)(spline.GetTotalLength() / setting.maxSpacing));
+
+			timer.Start();
+			spline.Tessellate();
+			spline.ComputeOffsetCurves();
+			spline.BuildTrackMesh();
+			double ms = timer.Elapsed();
+
+			out << std::setw(12) << std::fixed << std::setprecision(0) << straightLengths[t] << std::setw(24) << setting.name
+				<< std::setw(14) << spline.m_centrelinePoints.size() << std::setw(16) << spline.GetTrackMesh().GetVertexCount()
+				<< std::setw(12) << std::setprecision(4) << MaxTessellationError(spline) << std::setw(12) << std::setprecision(2) << ms << std::endl;
+		}
+	}
+	out << std::endl;
+}
+
+void BenchmarkTrackCulling(std::ostream &out)
+{
+	const int numViews = 1000;
+
+	vector<glm::vec3> controlPoints, noUpVectors;
+	MakeBenchmarkStadium(5000.0f, 200.0f, 10.0f, controlPoints);
+
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, noUpVectors);
+	spline.SetAdaptiveTessellation(2.0f, 0.02f, 20.0f);
+	spline.Tessellate();
+	spline.ComputeOffsetCurves();
+	spline.BuildTrackMesh();
+
+	const CTrackMesh &mesh = spline.GetTrackMesh();
+	const vector<TrackChunk> &chunks = mesh.GetChunks();
+	glm::mat4 projection = glm::perspective(45.0f, 800.0f / 600.0f, 0.5f, 5000.0f);
+
+	// A camera riding along the track, as in Game::Update, looking at a point a little further on
+	CHighResolutionTimer timer;
+	vector<TrackChunkDraw> visible;
+	double totalChunks = 0.0, totalTriangles = 0.0;
+	double ms = 0.0;
+	for (int v = 0; v < numViews; v++) {
+		float d = spline.GetTotalLength() * v / numViews;
+		glm::vec3 eye, target;
+		spline.Sample(d, eye);
+		spline.Sample(d + 8.0f, target);
+		eye.y += 3.0f;
+		glm::mat4 viewProjection = projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+		timer.Start();
+		spline.GetVisibleChunks(viewProjection, eye, visible);
+		ms += timer.Elapsed();
+
+		totalChunks += visible.size();
+		for (unsigned int i = 0; i < visible.size(); i++)
+			totalTriangles += chunks[visible[i].chunk].indexCount[visible[i].lod] / 3;
+	}
+
+	out << "Track chunk culling (" << std::fixed << std::setprecision(0) << spline.GetTotalLength() << " unit track, " << chunks.size() 
+		<< " chunks, " << numViews << " views)" << std::endl;
+	out << std::setw(32) << "whole track" << std::setw(16) << mesh.GetFullDetailIndexCount() / 3 << " triangles" << std::endl;
+	out << std::setw(32) << "visible chunks, with LOD" << std::setw(16) << totalTriangles / numViews << " triangles (" 
+		<< std::setprecision(1) << totalChunks / numViews << " chunks)" << std::endl;
+	out << std::setw(32) << "query time" << std::setw(16) << std::setprecision(2) << 1000.0 * ms / numViews << " us/view" << std::endl;
+	out << std::endl;
+}
+
+void BenchmarkTrackEditing(std::ostream &out)
+{
+	const int numControlPoints = 4096;
+	const int samplesPerSegment = 16;
+	const int numEdits = 1000;
+
+	vector<glm::vec3> controlPoints, upVectors;
+	MakeBenchmarkTrack(numControlPoints, 3.0f, controlPoints);
+	MakeBenchmarkUpVectors(numControlPoints, upVectors);
+
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, upVectors);
+
+	CHighResolutionTimer timer;
+	timer.Start();
+	spline.BeginEditing(samplesPerSegment);
+	double rebuildMs = timer.Elapsed();
+
+	// Bytes that the next RenderTrack would send: one block of vertices per changed segment
+	double blockBytes = 2.0 * (samplesPerSegment + 1) * sizeof(TrackVertex);
+
+	out << "Track editing (" << numControlPoints << " control points, " << samplesPerSegment << " samples per segment)" << std::endl;
+	out << std::setw(32) << "full rebuild" << std::setw(16) << std::fixed << std::setprecision(3) << rebuildMs << " ms" 
+		<< std::setw(16) << std::setprecision(0) << numControlPoints * blockBytes << " bytes" << std::endl;
+
+	const char *names[] = { "move", "insert", "remove" };
+	const int blocksPerEdit[] = { 5, 5, 4 };		// Segments i - 2 to i + 1 and the one before them, less one for a removal
+	srand(1234);
+	for (int op = 0; op < 3; op++) {
+		timer.Start();
+		for (int e = 0; e < numEdits; e++) {
+			int i = rand() % spline.GetNumControlPoints();
+			glm::vec3 p = spline.GetControlPoint(i) + glm::vec3(0.0f, 0.5f, 0.0f);
+			if (op == 0)
+				spline.MoveControlPoint(i, p, glm::vec3(0.0f, 1.0f, 0.0f));
+			else if (op == 1)
+				spline.InsertControlPoint(i, p, glm::vec3(0.0f, 1.0f, 0.0f));
+			else
+				spline.RemoveControlPoint(i);
+		}
+		double ms = timer.Elapsed();
+
+		out << std::setw(32) << names[op] << std::setw(16) << std::setprecision(3) << ms / numEdits << " ms" 
+			<< std::setw(16) << std::setprecision(0) << blocksPerEdit[op] * blockBytes << " bytes" << std::endl;
+	}
+	out << std::endl;
+}
+
+void BenchmarkTrackProjection(std::ostream &out)
+{
+	const int trackSizes[] = { 64, 512, 4096 };
+	const int numQueries = 100000;
+	const int numReferenceQueries = 1000;
+	const float fReferenceSpacing = 0.1f;
+
+	out << "CCatmullRom::ProjectToTrack (points up to 15 units to the side of the track)" << std::endl;
+	out << std::setw(16) << "control points" << std::setw(20) << "queries/second" << std::setw(24) << "brute force queries/s" 
+		<< std::setw(20) << "max distance error" << std::endl;
+
+	CHighResolutionTimer timer;
+	vector<glm::vec3> controlPoints, upVectors;
+	for (int s = 0; s < (int)(sizeof(trackSizes) / sizeof(trackSizes[0])); s++) {
+		MakeBenchmarkTrack(trackSizes[s], 3.0f, controlPoints);
+		MakeBenchmarkUpVectors(trackSizes[s], upVectors);
+
+		CCatmullRom spline;
+		spline.SetControlPoints(controlPoints, upVectors);
+		float fTotalLength = spline.GetTotalLength();
+
+		// Points scattered around the track, as cars and pickups would be
+		srand(1234);
+		vector<glm::vec3> queries(numQueries);
+		for (int i = 0; i < numQueries; i++) {
+			SplineSample sample;
+			spline.Sample(fTotalLength * ((float)rand() / (RAND_MAX + 1.0f)), sample);
+			glm::vec3 side = glm::normalize(glm::cross(sample.tangent, sample.up));
+			queries[i] = sample.position + side * (30.0f * rand() / RAND_MAX - 15.0f) + sample.up * (6.0f * rand() / RAND_MAX - 3.0f);
+		}
+
+		TrackProjection projection;
+		float checksum = 0.0f;
+		timer.Start();
+		for (int i = 0; i < numQueries; i++) {
+			spline.ProjectToTrack(queries[i], projection);
+			checksum += projection.distance;
+		}
+		double ms = timer.Elapsed();
+
+		// Reference: the closest point on a fine polyline through the centreline, searched exhaustively
+		int numReferencePoints = (int)(fTotalLength / fReferenceSpacing);
+		vector<glm::vec3> reference(numReferencePoints);
+		glm::vec3 up;
+		for (int i = 0; i < numReferencePoints; i++)
+			spline.Sample(fTotalLength * i / numReferencePoints, reference[i], up);
+
+		float maxError = 0.0f;
+		timer.Start();
+		for (int q = 0; q < numReferenceQueries; q++) {
+			const glm::vec3 &p = queries[q];
+			float fBest = FLT_MAX;
+			for (int i = 0; i < numReferencePoints; i++) {
+				glm::vec3 a = reference[i], ab = reference[(i + 1) % numReferencePoints] - a;
+				float w = glm::clamp(glm::dot(p - a, ab) / glm::dot(ab, ab), 0.0f, 1.0f);
+				glm::vec3 v = a + w * ab - p;
+				fBest = glm::min(fBest, glm::dot(v, v));
+			}
+
+			spline.ProjectToTrack(p, projection);
+			maxError = glm::max(maxError, fabsf(glm::length(p - projection.position) - sqrtf(fBest)));
+		}
+		double referenceMs = timer.Elapsed();
+
+		out << std::setw(16) << trackSizes[s] << std::setw(20) << std::fixed << std::setprecision(0) << numQueries / (ms / 1000.0) 
+			<< std::setw(24) << numReferenceQueries / (referenceMs / 1000.0) << std::setw(20) << std::setprecision(5) << maxError 
+			<< "   (checksum " << std::setprecision(2) << checksum << ")" << std::endl;
+	}
+	out << std::endl;
+}
+
+// Whether two splines tessellated and meshed the same control points into exactly the same bits
+static bool SameTrackBuild(const CCatmullRom &a, const CCatmullRom &b)
+{
+	const CTrackMesh &meshA = a.GetTrackMesh(), &meshB = b.GetTrackMesh();
+	return a.m_centrelinePoints.size() == b.m_centrelinePoints.size() && meshA.GetVertexCount() == meshB.GetVertexCount() && 
+		meshA.GetIndexCount() == meshB.GetIndexCount() && meshA.GetIndexSize() == meshB.GetIndexSize() && 
+		memcmp(&a.m_centrelinePoints[0], &b.m_centrelinePoints[0], a.m_centrelinePoints.size() * sizeof(glm::vec3)) == 0 && 
+		memcmp(&a.m_centrelineDistances[0], &b.m_centrelineDistances[0], a.m_centrelineDistances.size() * sizeof(float)) == 0 && 
+		memcmp(&a.m_centrelineFrames[0], &b.m_centrelineFrames[0], a.m_centrelineFrames.size() * sizeof(TrackFrame)) == 0 && 
+		memcmp(meshA.GetVertexData(), meshB.GetVertexData(), meshA.GetVertexCount() * sizeof(TrackVertex)) == 0 && 
+		memcmp(meshA.GetIndexData(), meshB.GetIndexData(), meshA.GetIndexCount() * meshA.GetIndexSize()) == 0;
+}
+
+void BenchmarkTrackBuild(std::ostream &out)
+{
+	const int numControlPoints = 32768;
+	const int numUniformSamples = 200000;
+
+	vector<glm::vec3> controlPoints, upVectors;
+	MakeBenchmarkTrack(numControlPoints, 3.0f, controlPoints);
+	MakeBenchmarkUpVectors(numControlPoints, upVectors);
+
+	int maxThreads = GetParallelThreadCount();
+	vector<int> threadCounts;
+	for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+		threadCounts.push_back(numThreads);
+	threadCounts.push_back(maxThreads);
+
+	for (int adaptive = 0; adaptive < 2; adaptive++) {
+		CCatmullRom serial;
+
+		out << "Track build (" << numControlPoints << " control points, ";
+		if (adaptive)
+			out << "adaptive tessellation)" << std::endl;
+		else
+			out << numUniformSamples << " uniform samples)" << std::endl;
+		out << std::setw(16) << "threads" << std::setw(16) << "samples" << std::setw(20) << "tessellate ms" << std::setw(16) << "offsets ms" 
+			<< std::setw(16) << "mesh ms" << std::setw(16) << "total ms" << std::setw(16) << "same as serial" << std::endl;
+
+		for (unsigned int t = 0; t < threadCounts.size(); t++) {
+			SetParallelThreadCount(threadCounts[t]);
+
+			CCatmullRom spline;
+			spline.SetControlPoints(controlPoints, upVectors);
+			if (adaptive)
+				spline.SetAdaptiveTessellation(2.0f, 0.002f, 2.0f);
+			else
+				spline.SetUniformTessellation(numUniformSamples);
+
+			// Tessellate also computes the arc length tables and the frames
+			CHighResolutionTimer timer;
+			timer.Start();
+			spline.Tessellate();
+			double tessellateMs = timer.Elapsed();
+			timer.Start();
+			spline.ComputeOffsetCurves();
+			double offsetsMs = timer.Elapsed();
+			timer.Start();
+			spline.BuildTrackMesh();
+			double meshMs = timer.Elapsed();
+
+			bool bSame = true;
+			if (t == 0) {
+				serial.SetControlPoints(controlPoints, upVectors);
+				if (adaptive)
+					serial.SetAdaptiveTessellation(2.0f, 0.002f, 2.0f);
+				else
+					serial.SetUniformTessellation(numUniformSamples);
+				serial.Tessellate();
+				serial.ComputeOffsetCurves();
+				serial.BuildTrackMesh();
+			}
+			else
+				bSame = SameTrackBuild(serial, spline);
+
+			out << std::setw(16) << threadCounts[t] << std::setw(16) << spline.m_centrelinePoints.size() << std::fixed << std::setprecision(2) 
+				<< std::setw(20) << tessellateMs << std::setw(16) << offsetsMs << std::setw(16) << meshMs << std::setw(16) 
+				<< tessellateMs + offsetsMs + meshMs << std::setw(16) << (bSame ? "yes" : "NO") << std::endl;
+		}
+		out << std::endl;
+	}
+
+	SetParallelThreadCount(0);
+}
+
+// A loop with unevenly spaced control points: long straights, with hairpins whose points are bunched up, as on the tighter tracks
+static void MakeBenchmarkHairpins(int numHairpins, vector<glm::vec3> &controlPoints)
+{
+	controlPoints.clear();
+	for (int h = 0; h < numHairpins; h++) {
+		float angle = 2.0f * (float)M_PI * h / numHairpins;
+		glm::vec3 outward(cosf(angle), 0.0f, sinf(angle)), side(-sinf(angle), 0.0f, cosf(angle));
+		controlPoints.push_back(100.0f * outward - 10.0f * side);
+		controlPoints.push_back(400.0f * outward - 6.0f * side);
+		controlPoints.push_back(404.0f * outward);
+		controlPoints.push_back(400.0f * outward + 6.0f * side);
+		controlPoints.push_back(100.0f * outward + 10.0f * side);
+	}
+}
+
+void BenchmarkParameterization(std::ostream &out)
+{
+	const int numQueries = 1000000;
+	const int numBuilds = 100;
+	const char *names[] = { "uniform", "centripetal", "chordal", "Kochanek-Bartels" };
+	const SplineParameterizationType types[] = { SPLINE_UNIFORM, SPLINE_CENTRIPETAL, SPLINE_CHORDAL, SPLINE_KOCHANEK_BARTELS };
+
+	vector<glm::vec3> controlPoints, noUpVectors;
+	MakeBenchmarkHairpins(12, controlPoints);
+
+	out << "Spline parameterizations (" << controlPoints.size() << " control points, hairpins with bunched up points)" << std::endl;
+	out << std::setw(20) << "parameterization" << std::setw(16) << "build us" << std::setw(20) << "samples/second" << std::setw(16) << "track length" 
+		<< std::setw(24) << "min radius of curvature" << std::endl;
+
+	CHighResolutionTimer timer;
+	for (int p = 0; p < 4; p++) {
+		CCatmullRom spline;
+		spline.SetParameterization(types[p]);
+
+		timer.Start();
+		for (int b = 0; b < numBuilds; b++)
+			spline.SetControlPoints(controlPoints, noUpVectors);
+		double buildMs = timer.Elapsed() / numBuilds;
+
+		float fTotalLength = spline.GetTotalLength();
+		glm::vec3 point, up;
+		glm::vec3 checksum(0.0f);
+		timer.Start();
+		for (int i = 0; i < numQueries; i++) {
+			spline.Sample(fTotalLength * i / numQueries, point, up);
+			checksum += point;
+		}
+		double ms = timer.Elapsed();
+
+		// A cusp or a kink shows up as a tiny radius of curvature
+		float maxCurvature = 0.0f;
+		SplineSample sample;
+		for (float d = 0.0f; d < fTotalLength; d += 0.05f) {
+			spline.Sample(d, sample);
+			maxCurvature = glm::max(maxCurvature, sample.curvature);
+		}
+
+		out << std::setw(20) << names[p] << std::setw(16) << std::fixed << std::setprecision(1) << 1000.0 * buildMs << std::setw(20) 
+			<< std::setprecision(0) << numQueries / (ms / 1000.0) << std::setw(16) << fTotalLength << std::setw(24) << std::setprecision(3) 
+			<< 1.0f / maxCurvature << "   (checksum " << std::setprecision(2) << checksum.x + checksum.y + checksum.z << ")" << std::endl;
+	}
+	out << std::endl;
+}
+
+void BenchmarkRingBroadphase(std::ostream &out)
+{
+	const int ringCounts[] = { 100, 10000, 1000000 };
+	const int numFrames = 1000;
+	const float fRadius = 2.0f;
+	const float fWindow = 10.0f;
+
+	vector<glm::vec3> controlPoints, noUpVectors;
+	MakeBenchmarkTrack(4096, 3.0f, controlPoints);
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, noUpVectors);
+	spline.Tessellate();
+	float fTotalLength = spline.GetTotalLength();
+
+	// The player rides once round the lap, weaving from side to side as in Game::Update
+	vector<float> playerDistances(numFrames);
+	vector<glm::vec3> playerPositions(numFrames);
+	for (int f = 0; f < numFrames; f++) {
+		TrackFrame frame;
+		playerDistances[f] = fTotalLength * f / numFrames;
+		spline.Sample(playerDistances[f], playerPositions[f]);
+		spline.SampleFrame(playerDistances[f], frame);
+		playerPositions[f] += 2.0f * sinf(0.1f * f) * frame.N;
+	}
+
+	out << "Ring collision broadphase (" << std::fixed << std::setprecision(0) << fTotalLength << " unit track, " << numFrames << " frames)" << std::endl;
+	out << std::setw(16) << "rings" << std::setw(20) << "build ms" << std::setw(20) << "index us/frame" << std::setw(20) << "all rings us/frame" 
+		<< std::setw(16) << "hits" << std::endl;
+
+	CHighResolutionTimer timer;
+	for (int r = 0; r < (int)(sizeof(ringCounts) / sizeof(ringCounts[0])); r++) {
+		int numRings = ringCounts[r];
+
+		// Rings either side of the centreline, 1.5 units up, as Game::AddRings places them
+		srand(1234);
+		vector<float> distances(numRings);
+		vector<glm::vec3> positions(numRings);
+		vector<glm::mat4> transforms(numRings);
+		for (int i = 0; i < numRings; i++) {
+			TrackFrame frame;
+			distances[i] = fTotalLength * ((float)rand() / (RAND_MAX + 1.0f));
+			spline.Sample(distances[i], positions[i]);
+			spline.SampleFrame(distances[i], frame);
+			positions[i] += glm::vec3(0.0f, 1.5f, 0.0f) + (rand() % 2 ? 3.0f : -3.0f) * frame.N;
+			transforms[i] = glm::translate(positions[i]);
+		}
+
+		CRingIndex index;
+		timer.Start();
+		index.Build(distances, positions, fTotalLength);
+		double buildMs = timer.Elapsed();
+
+		vector<int> hits;
+		int numHits = 0;
+		timer.Start();
+		for (int f = 0; f < numFrames; f++) {
+			hits.clear();
+			index.FindNear(playerDistances[f], playerPositions[f], fRadius, fWindow, hits);
+			numHits += (int)hits.size();
+		}
+		double indexMs = timer.Elapsed();
+
+		// The loop Game::Update used to run: every ring's position pulled out of its transform
+		int numBruteForceFrames = numRings > 10000 ? 20 : numFrames;
+		int numBruteForceHits = 0, numIndexHits = 0;
+		timer.Start();
+		for (int f = 0; f < numBruteForceFrames; f++) {
+			for (int i = 0; i < numRings; i++) {
+				glm::vec4 translationColumn = transforms[i] * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+				if (glm::length(glm::vec3(translationColumn) - playerPositions[f]) < fRadius)
+					numBruteForceHits++;
+			}
+		}
+		double bruteForceMs = timer.Elapsed();
+		for (int f = 0; f < numBruteForceFrames; f++) {
+			hits.clear();
+			index.FindNear(playerDistances[f], playerPositions[f], fRadius, fWindow, hits);
+			numIndexHits += (int)hits.size();
+		}
+
+		out << std::setw(16) << numRings << std::setw(20) << std::setprecision(3) << buildMs << std::setw(20) << 1000.0 * indexMs / numFrames 
+			<< std::setw(20) << 1000.0 * bruteForceMs / numBruteForceFrames << std::setw(16) << numHits 
+			<< (numIndexHits == numBruteForceHits ? "" : "   (MISMATCH against all rings)") << std::endl;
+	}
+	out << std::endl;
+}
+
+void BenchmarkEntityStore(std::ostream &out)
+{
+	const int numEntities = 1000000;
+	const int numPasses = 10;
+
+	CHighResolutionTimer timer;
+	srand(1234);
+
+	// The old layout: a transform per ring, with collected rings reset to the identity but still visited
+	vector<glm::mat4> transforms(numEntities);
+	CEntityStore store;
+	timer.Start();
+	for (int i = 0; i < numEntities; i++) {
+		glm::vec3 position(1000.0f * rand() / RAND_MAX, 0.0f, 1000.0f * rand() / RAND_MAX);
+		glm::quat orientation = glm::angleAxis(360.0f * rand() / RAND_MAX, glm::vec3(0.0f, 1.0f, 0.0f));
+		store.Create(ENTITY_RING, position, orientation, 1.0f);
+		transforms[i] = glm::translate(glm::mat4(), position) * glm::mat4_cast(orientation);
+	}
+	double createMs = timer.Elapsed();
+
+	// Collect three quarters of them
+	for (int i = 0; i < numEntities; i++) {
+		if (rand() % 4 != 0) {
+			store.Kill(i);
+			transforms[i] = glm::mat4();
+		}
+	}
+	timer.Start();
+	store.Compact();
+	double compactMs = timer.Elapsed();
+
+	// A collision style pass over the positions
+	glm::vec3 player(500.0f, 0.0f, 500.0f);
+	int numNear = 0;
+	timer.Start();
+	for (int pass = 0; pass < numPasses; pass++) {
+		for (int i = 0; i < numEntities; i++) {
+			glm::vec4 translationColumn = transforms[i] * glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+			if (glm::length(glm::vec3(translationColumn) - player) < 100.0f)
+				numNear++;
+		}
+	}
+	double transformMs = timer.Elapsed() / numPasses;
+
+	int numNearStore = 0;
+	timer.Start();
+	for (int pass = 0; pass < numPasses; pass++) {
+		const glm::vec3 *pPositions = store.GetPositions();
+		for (int i = 0; i < store.GetCount(); i++) {
+			glm::vec3 v = pPositions[i] - player;
+			if (glm::dot(v, v) < 100.0f * 100.0f)
+				numNearStore++;
+		}
+	}
+	double storeMs = timer.Elapsed() / numPasses;
+
+	out << "CEntityStore (" << numEntities << " rings, three quarters collected)" << std::endl;
+	out << std::setw(40) << "create" << std::setw(16) << std::fixed << std::setprecision(3) << createMs << " ms" << std::endl;
+	out << std::setw(40) << "compact" << std::setw(16) << compactMs << " ms" << std::endl;
+	out << std::setw(40) << "distance pass, transform array" << std::setw(16) << transformMs << " ms   (" << numNear / numPasses << " near)" << std::endl;
+	out << std::setw(40) << "distance pass, store positions" << std::setw(16) << storeMs << " ms   (" << numNearStore / numPasses << " near, " 
+		<< store.GetCount() << " live)" << std::endl;
+	out << std::endl;
+}
+
+void BenchmarkSweptCollision(std::ostream &out)
+{
+	const int numRings = 10000;
+	const float steps[] = { 0.5f, 2.0f, 8.0f, 32.0f };
+	const float fRadius = 2.0f;
+	const float fWindow = 10.0f;
+
+	vector<glm::vec3> controlPoints, noUpVectors;
+	MakeBenchmarkTrack(4096, 3.0f, controlPoints);
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, noUpVectors);
+	spline.Tessellate();
+	float fTotalLength = spline.GetTotalLength();
+
+	// Rings just above the centreline, all on the player's path
+	vector<float> distances(numRings);
+	vector<glm::vec3> positions(numRings);
+	for (int i = 0; i < numRings; i++) {
+		distances[i] = fTotalLength * (i + 0.5f) / numRings;
+		spline.Sample(distances[i], positions[i]);
+		positions[i] += glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+
+	out << "Swept ring collision (" << numRings << " rings on the player's path, one lap)" << std::endl;
+	out << std::setw(16) << "step" << std::setw(20) << "point test hits" << std::setw(16) << "us/frame" << std::setw(20) << "swept hits" 
+		<< std::setw(16) << "us/frame" << std::endl;
+
+	CHighResolutionTimer timer;
+	vector<int> hits;
+	for (int s = 0; s < (int)(sizeof(steps) / sizeof(steps[0])); s++) {
+		int numFrames = (int)ceilf(fTotalLength / steps[s]);
+		vector<float> playerDistances(numFrames + 1);
+		vector<glm::vec3> playerPositions(numFrames + 1);
+		for (int f = 0; f <= numFrames; f++) {
+			playerDistances[f] = glm::min(steps[s] * f, fTotalLength);
+			spline.Sample(playerDistances[f], playerPositions[f]);
+		}
+
+		// The test Game::Update used to make, at the end of each frame's movement
+		CRingIndex index;
+		index.Build(distances, positions, fTotalLength);
+		int numPointHits = 0;
+		timer.Start();
+		for (int f = 1; f <= numFrames; f++) {
+			hits.clear();
+			index.FindNear(playerDistances[f], playerPositions[f], fRadius, fWindow, hits);
+			for (size_t h = 0; h < hits.size(); h++)
+				index.Remove(hits[h]);
+			numPointHits += (int)hits.size();
+		}
+		double pointMs = timer.Elapsed();
+
+		index.Build(distances, positions, fTotalLength);
+		int numSweptHits = 0;
+		timer.Start();
+		for (int f = 1; f <= numFrames; f++) {
+			hits.clear();
+			index.FindSwept(playerDistances[f - 1], playerDistances[f], playerPositions[f - 1], playerPositions[f], fRadius, fWindow, hits);
+			for (size_t h = 0; h < hits.size(); h++)
+				index.Remove(hits[h]);
+			numSweptHits += (int)hits.size();
+		}
+		double sweptMs = timer.Elapsed();
+
+		out << std::setw(16) << std::fixed << std::setprecision(1) << steps[s] << std::setw(20) << numPointHits << std::setw(16) << std::setprecision(3) 
+			<< 1000.0 * pointMs / numFrames << std::setw(20) << numSweptHits << std::setw(16) << 1000.0 * sweptMs / numFrames << std::endl;
+	}
+
+	// Sphere against torus, for ring shaped obstacles: random sweeps through the neighbourhood of a torus with the proportions of a ring
+	const int numSweeps = 1000000;
+	vector<glm::vec3> starts(numSweeps), ends(numSweeps);
+	srand(1234);
+	for (int i = 0; i < numSweeps; i++) {
+		starts[i] = glm::vec3(rand() % 2001 - 1000.0f, rand() % 2001 - 1000.0f, rand() % 2001 - 1000.0f) * 0.006f;
+		ends[i] = glm::vec3(rand() % 2001 - 1000.0f, rand() % 2001 - 1000.0f, rand() % 2001 - 1000.0f) * 0.006f;
+	}
+	int numTorusHits = 0, numBoundHits = 0;
+	float t;
+	timer.Start();
+	for (int i = 0; i < numSweeps; i++) {
+		if (SweepSphereTorus(starts[i], ends[i], 0.5f, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 2.0f, 0.3f, t))
+			numTorusHits++;
+	}
+	double torusMs = timer.Elapsed();
+	for (int i = 0; i < numSweeps; i++) {
+		if (SweepSphereSphere(starts[i], ends[i], 0.5f, glm::vec3(0.0f), 2.3f, t))
+			numBoundHits++;
+	}
+
+	out << std::setw(36) << "sphere against torus" << std::setw(16) << std::setprecision(0) << numSweeps / (torusMs / 1000.0) << " sweeps/second   (" 
+		<< numTorusHits << " hits, " << numBoundHits << " through the bounding sphere)" << std::endl;
+	out << std::endl;
+}
+
+void BenchmarkPlacement(std::ostream &out)
+{
+	const int numControlPoints = 4096;
+
+	vector<glm::vec3> controlPoints, noUpVectors;
+	MakeBenchmarkTrack(numControlPoints, 3.0f, controlPoints);
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, noUpVectors);
+	spline.Tessellate();
+	float fTotalLength = spline.GetTotalLength();
+
+	// A density that rises and falls round the lap, averaging an item every half unit, with a step halfway
+	vector<DensityKey> density;
+	for (int i = 0; i <= 64; i++) {
+		DensityKey key = { fTotalLength * i / 64.0f, 2.0f + 1.5f * sinf(0.5f * i) };
+		if (i == 32) {
+			DensityKey before = { key.distance, 0.5f };
+			density.push_back(before);
+		}
+		density.push_back(key);
+	}
+
+	CPlacementGenerator placement;
+	placement.SetSeed(1234);
+	placement.SetDensity(density);
+	placement.SetRange(0.0f, fTotalLength);
+	placement.SetOffsets(3.0f, 1.5f);
+	placement.SetJitter(0.5f);
+
+	// Chunk by chunk on this thread, for reference
+	CHighResolutionTimer timer;
+	vector<PlacedItem> serial;
+	timer.Start();
+	for (int c = 0; c < placement.GetNumChunks(); c++)
+		placement.GenerateChunk(spline, c, serial);
+	double serialMs = timer.Elapsed();
+
+	out << "Placement (" << std::fixed << std::setprecision(0) << fTotalLength << " unit track, " << placement.GetNumChunks() << " chunks, " 
+		<< std::setprecision(1) << placement.GetExpectedCount() << " items expected)" << std::endl;
+	out << std::setw(16) << "threads" << std::setw(16) << "items" << std::setw(16) << "ms" << std::setw(16) << "same" << std::endl;
+	out << std::setw(16) << "serial" << std::setw(16) << serial.size() << std::setw(16) << std::setprecision(2) << serialMs << std::endl;
+
+	// More threads than cores still checks that splitting the chunks differently gives the same layout
+	int threadCounts[] = { 1, 2, 3, 8, GetParallelThreadCount() };
+	for (int t = 0; t < (int)(sizeof(threadCounts) / sizeof(threadCounts[0])); t++) {
+		SetParallelThreadCount(threadCounts[t]);
+		vector<PlacedItem> items;
+		timer.Start();
+		placement.Generate(spline, items);
+		double ms = timer.Elapsed();
+
+		bool bSame = items.size() == serial.size();
+		for (size_t i = 0; bSame && i < items.size(); i++)
+			bSame = items[i].index == serial[i].index && items[i].distance == serial[i].distance && items[i].position == serial[i].position;
+
+		out << std::setw(16) << threadCounts[t] << std::setw(16) << items.size() << std::setw(16) << ms << std::setw(16) << (bSame ? "yes" : "NO") << std::endl;
+	}
+	SetParallelThreadCount(0);
+
+	// Items in order, one per count, and the count between any two distances close to the integral of the density
+	bool bOrdered = true;
+	for (size_t i = 1; i < serial.size(); i++)
+		bOrdered = bOrdered && serial[i].index == serial[i - 1].index + 1 && serial[i].distance >= serial[i - 1].distance;
+	int numFirstHalf = 0;
+	for (size_t i = 0; i < serial.size(); i++)
+		numFirstHalf += serial[i].distance < 0.5f * fTotalLength ? 1 : 0;
+	float fExpectedFirstHalf = 0.0f;
+	for (size_t i = 1; i < density.size() && density[i].distance <= 0.5f * fTotalLength; i++)
+		fExpectedFirstHalf += 0.5f * (density[i].distance - density[i - 1].distance) * (density[i].density + density[i - 1].density);
+	out << std::setw(32) << "in order" << std::setw(16) << (bOrdered ? "yes" : "NO") << std::endl;
+	out << std::setw(32) << "first half of the lap" << std::setw(16) << numFirstHalf << " items, " << std::setprecision(1) << fExpectedFirstHalf 
+		<< " expected" << std::endl;
+	out << std::endl;
+}
+
+void BenchmarkFramePacer(std::ostream &out)
+{
+	const int numFrames = 120;
+	const double intervalMs = 1000.0 / 60.0;
+	const double workMs = 3.0;			// Standing in for Update and Render
+
+	CHighResolutionTimer wall, frame, work;
+
+	// The old loop: poll the timer until a frame's worth of time has passed
+	double cpuStart = PlatformProcessCpuMs();
+	wall.Start();
+	frame.Start();
+	for (int n = 0; n < numFrames; ) {
+		if (frame.Elapsed() > intervalMs) {
+			frame.Start();
+			work.Start();
+			while (work.Elapsed() < workMs) {}
+			n++;
+		}
+	}
+	double pollWallMs = wall.Elapsed();
+	double pollCpuMs = PlatformProcessCpuMs() - cpuStart;
+
+	CFramePacer pacer;
+	pacer.SetTargetInterval(intervalMs);
+	double totalError = 0.0;
+	cpuStart = PlatformProcessCpuMs();
+	wall.Start();
+	for (int n = 0; n < numFrames; n++) {
+		pacer.WaitForNextFrame();
+		totalError += pacer.GetLastError();
+		work.Start();
+		while (work.Elapsed() < workMs) {}
+	}
+	double pacerWallMs = wall.Elapsed();
+	double pacerCpuMs = PlatformProcessCpuMs() - cpuStart;
+
+	out << "Frame pacing (" << numFrames << " frames at 60 Hz, " << std::fixed << std::setprecision(1) << workMs << " ms of work each)" << std::endl;
+	out << std::setw(24) << "" << std::setw(16) << "wall ms" << std::setw(16) << "cpu ms" << std::setw(20) << "mean error ms" << std::setw(16) << "max error ms" << std::endl;
+	out << std::setw(24) << "busy poll" << std::setw(16) << pollWallMs << std::setw(16) << pollCpuMs << std::endl;
+	out << std::setw(24) << "CFramePacer" << std::setw(16) << pacerWallMs << std::setw(16) << pacerCpuMs << std::setw(20) << std::setprecision(3) 
+		<< totalError / numFrames << std::setw(16) << pacer.GetMaxError() << "   (" << pacer.GetNumMissed() << " missed)" << std::endl;
+	out << std::endl;
+}
+
+// The stages of the continuation test in BenchmarkJobSystem: each job of the second stage reads two results of the first, and 
+// the last job adds up the second stage
+struct JobChain
+{
+	int values[64];
+	int pairs[64];
+	int total;
+};
+
+static void JobChainFill(void *pData, int first, int last)
+{
+	JobChain *pChain = (JobChain *)pData;
+	for (int i = first; i < last; i++)
+		pChain->values[i] = i;
+}
+
+static void JobChainPairs(void *pData, int first, int last)
+{
+	JobChain *pChain = (JobChain *)pData;
+	for (int i = first; i < last; i++)
+		pChain->pairs[i] = pChain->values[i] + pChain->values[(i + 1) % 64];
+}
+
+static void JobChainTotal(void *pData, int, int)
+{
+	JobChain *pChain = (JobChain *)pData;
+	pChain->total = 0;
+	for (int i = 0; i < 64; i++)
+		pChain->total += pChain->pairs[i];
+}
+
+void BenchmarkJobSystem(std::ostream &out)
+{
+	const int numControlPoints = 32768;
+	const int numSamples = 1000000;
+	const int numUneven = 100000;
+
+	vector<glm::vec3> controlPoints, upVectors;
+	MakeBenchmarkTrack(numControlPoints, 3.0f, controlPoints);
+	MakeBenchmarkUpVectors(numControlPoints, upVectors);
+	CCatmullRom spline;
+	spline.SetControlPoints(controlPoints, upVectors);
+	spline.Tessellate();
+	float fTotalLength = spline.GetTotalLength();
+
+	int maxThreads = CJobSystem::GetInstance().GetNumThreads();
+	vector<int> threadCounts;
+	for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+		threadCounts.push_back(numThreads);
+	threadCounts.push_back(maxThreads);
+
+	// Even: every element samples the track once.  Uneven: elements sample it from 1 to 32 times, more towards the end of the 
+	// range, which a split into one range per thread handles badly.
+	vector<glm::vec3> positions(numSamples);
+	auto evenLoad = [&](int first, int last) {
+		glm::vec3 up;
+		for (int i = first; i < last; i++)
+			spline.Sample(fTotalLength * i / numSamples, positions[i], up);
+	};
+	auto unevenLoad = [&](int first, int last) {
+		glm::vec3 p, up;
+		for (int i = first; i < last; i++) {
+			int numRepeats = 1 + (int)(31LL * i * i / ((long long)numUneven * numUneven));
+			glm::vec3 sum(0.0f);
+			for (int k = 0; k < numRepeats; k++) {
+				spline.Sample(fTotalLength * (i + 0.01f * k) / numUneven, p, up);
+				sum += p;
+			}
+			positions[i] = sum;
+		}
+	};
+
+	out << "Job system (" << std::thread::hardware_concurrency() << " hardware threads; speedup and efficiency against 1 thread)" << std::endl;
+	out << std::setw(16) << "threads" << std::setw(16) << "even ms" << std::setw(12) << "speedup" << std::setw(12) << "efficiency" 
+		<< std::setw(16) << "uneven ms" << std::setw(12) << "speedup" << std::setw(12) << "efficiency" << std::setw(20) << "1 range/thread ms" 
+		<< std::setw(16) << "small loop us" << std::endl;
+
+	double evenMs1 = 0.0, unevenMs1 = 0.0;
+	CHighResolutionTimer timer;
+	for (unsigned int t = 0; t < threadCounts.size(); t++) {
+		int numThreads = threadCounts[t];
+		CJobSystem::GetInstance().SetNumThreads(numThreads);
+		ParallelFor(0, 1024, 1, [](int, int) {});	// Start the workers outside the timings
+
+		timer.Start();
+		ParallelFor(0, numSamples, 1024, evenLoad);
+		double evenMs = timer.Elapsed();
+
+		timer.Start();
+		ParallelFor(0, numUneven, 64, unevenLoad);
+		double unevenMs = timer.Elapsed();
+
+		// The same uneven loop without stealing: as many ranges as threads, as the old thread per range ParallelFor made
+		timer.Start();
+		ParallelFor(0, numUneven, numUneven / numThreads, unevenLoad);
+		double staticMs = timer.Elapsed();
+
+		// Many short loops, where the cost is all in handing out the jobs
+		const int numSmallLoops = 2000;
+		timer.Start();
+		for (int l = 0; l < numSmallLoops; l++)
+			ParallelFor(0, 4096, 256, [&](int first, int last) {
+				for (int i = first; i < last; i++)
+					positions[i] = glm::vec3((float)i);
+			});
+		double smallUs = 1000.0 * timer.Elapsed() / numSmallLoops;
+
+		if (t == 0) {
+			evenMs1 = evenMs;
+			unevenMs1 = unevenMs;
+		}
+		out << std::setw(16) << numThreads << std::fixed << std::setprecision(2) << std::setw(16) << evenMs << std::setw(12) << evenMs1 / evenMs 
+			<< std::setw(12) << evenMs1 / evenMs / numThreads << std::setw(16) << unevenMs << std::setw(12) << unevenMs1 / unevenMs << std::setw(12) 
+			<< unevenMs1 / unevenMs / numThreads << std::setw(20) << staticMs << std::setw(16) << smallUs << std::endl;
+	}
+
+	// Fill, then pairs after the fill, then a total after the pairs, all submitted up front and released by the counters
+	const int numChains = 1000;
+	bool bCorrect = true;
+	JobChain chain;
+	timer.Start();
+	for (int c = 0; c < numChains; c++) {
+		CJobCounter filled, paired, totalled;
+		memset(&chain, 0, sizeof(chain));
+		Job job;
+		job.pData = &chain;
+		for (int j = 0; j < 8; j++) {
+			job.function = JobChainFill;
+			job.first = 8 * j;
+			job.last = 8 * j + 8;
+			job.pCounter = &filled;
+			CJobSystem::GetInstance().Submit(job);
+		}
+		for (int j = 0; j < 8; j++) {
+			job.function = JobChainPairs;
+			job.first = 8 * j;
+			job.last = 8 * j + 8;
+			job.pCounter = &paired;
+			CJobSystem::GetInstance().SubmitAfter(filled, job);
+		}
+		job.function = JobChainTotal;
+		job.first = job.last = 0;
+		job.pCounter = &totalled;
+		CJobSystem::GetInstance().SubmitAfter(paired, job);
+		CJobSystem::GetInstance().Wait(totalled);
+		CJobSystem::GetInstance().Wait(paired);
+		CJobSystem::GetInstance().Wait(filled);
+		bCorrect = bCorrect && chain.total == 2 * (63 * 64 / 2);
+	}
+	double chainUs = 1000.0 * timer.Elapsed() / numChains;
+	out << std::setw(32) << "continuation chain" << std::setw(16) << std::setprecision(2) << chainUs << " us, " 
+		<< (bCorrect ? "in order" : "OUT OF ORDER") << std::endl;
+	out << std::endl;
+
+	CJobSystem::GetInstance().SetNumThreads(0);
+}
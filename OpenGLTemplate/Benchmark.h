@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Common.h"
+#include <ostream>
+
+// Micro-benchmarks for the CPU side of the game (spline sampling, track building, etc.).
+// Run with "OpenGLTemplate.exe -benchmark".  No window or GL context is created, results are written to out.
+void RunBenchmarks(std::ostream &out);
+
+void BenchmarkSplineSample(std::ostream &out);	// Samples per second against the number of control points
+void BenchmarkSplineSampleBatch(std::ostream &out);	// CCatmullRom::SampleBatch against a loop over Sample, with the largest difference between them
+void BenchmarkSplineCursor(std::ostream &out);		// CSplineCursor against CCatmullRom::Sample for distances that creep forward, as in Game::Update
+void BenchmarkTessellation(std::ostream &out);		// Centreline points and track vertices for uniform and adaptive tessellation, with the error against the true curve
+void BenchmarkTrackCulling(std::ostream &out);		// Triangles submitted for views along a long track with chunk culling and LOD, against the whole track
+void BenchmarkTrackEditing(std::ostream &out);		// Moving, inserting and removing control points against rebuilding the whole track, with the bytes to upload
+void BenchmarkTrackProjection(std::ostream &out);	// ProjectToTrack against an exhaustive search of a fine polyline through the centreline
+void BenchmarkTrackBuild(std::ostream &out);		// Time for each stage of building a long track against the number of threads, checking the results match the serial build
+void BenchmarkParameterization(std::ostream &out);	// Build and sampling speed of each parameterization, and the tightest curvature each gives on a track with hairpins
+void BenchmarkRingBroadphase(std::ostream &out);		// CRingIndex queries for a player riding round the track, against testing every ring, for up to a million rings
+void BenchmarkEntityStore(std::ostream &out);		// Creating, killing and compacting entities, and a pass over the live positions against the old transform array
+void BenchmarkSweptCollision(std::ostream &out);	// Rings picked up by point and swept tests as the player's step per frame grows, and the speed of the sphere-torus sweep
+void BenchmarkPlacement(std::ostream &out);		// CPlacementGenerator against the number of threads, checking the layout matches chunk by chunk generation and follows the density
+void BenchmarkFramePacer(std::ostream &out);		// CPU time and pacing error of CFramePacer against the old busy polling loop, at the same frame rate
+void BenchmarkJobSystem(std::ostream &out);		// Speedup and efficiency of CJobSystem::ParallelFor against the number of threads, for even and uneven loads, with the cost of small loops and of a chain of continuations
@@ -1,29 +1,200 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include "CCatmullRom.h"
+#include "Frustum.h"
+#include "TrackFile.h"
+#include "TrackCache.h"
+#include "Parallel.h"
 #include <iostream>
+#include <algorithm>
+#include <float.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CATMULLROM_SSE2
+#include <emmintrin.h>
+#endif
+
+// Smallest adaptive tessellation tolerances SetAdaptiveTessellation accepts
+static const float MIN_TESSELLATION_ANGLE = 0.1f;		// Degrees
+static const float MIN_TESSELLATION_SPACING = 0.01f;
 
 CCatmullRom::CCatmullRom()
 {
-	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_adaptiveTessellation = false;
+	m_numUniformSamples = 500;
+	m_maxAngle = 0.0f;
+	m_maxChordError = 0.0f;
+	m_maxSpacing = 0.0f;
+	m_chunkLength = 100.0f;
+	m_indexType = GL_UNSIGNED_SHORT;
 	m_currentDistance = 0.0f;
+	m_vaoCentreline = 0;
+	m_vaoLeftOffsetCurve = 0;
+	m_vaoRightOffsetCurve = 0;
+	m_vaoTrack = 0;
+	m_editing = false;
+	m_samplesPerSegment = 0;
+	m_trackBuffersStale = false;
+	m_curveBuffersStale = false;
+	m_vboTrackVertices = 0;
+	m_vboTrackIndices = 0;
+	SetParameterization<UniformParameterization>();
 }
 
 CCatmullRom::~CCatmullRom()
 {}
 
-// Perform Catmull Rom spline interpolation between four points, interpolating the space between p1 and p2
-glm::vec3 CCatmullRom::Interpolate(glm::vec3 &p0, glm::vec3 &p1, glm::vec3 &p2, glm::vec3 &p3, float t)
+void CCatmullRom::SetParameterization(SplineParameterizationType type)
+{
+	switch (type) {
+	case SPLINE_CENTRIPETAL:
+		SetParameterization<CentripetalParameterization>();
+		break;
+	case SPLINE_CHORDAL:
+		SetParameterization<ChordalParameterization>();
+		break;
+	case SPLINE_KOCHANEK_BARTELS:
+		SetParameterization<KochanekBartelsParameterization<TightTCB> >();
+		break;
+	default:
+		SetParameterization<UniformParameterization>();
+		break;
+	}
+}
+
+// Evaluate a + b t + c t^2 + d t^3 in Horner form
+glm::vec3 CCatmullRom::Evaluate(const SplineSegment &segment, float t)
+{
+	return ((segment.d * t + segment.c) * t + segment.b) * t + segment.a;
+}
+
+// Evaluate the derivative b + 2c t + 3d t^2 in Horner form
+glm::vec3 CCatmullRom::EvaluateDerivative(const SplineSegment &segment, float t)
+{
+	return (3.0f * segment.d * t + 2.0f * segment.c) * t + segment.b;
+}
+
+// Evaluate the second derivative 2c + 6d t
+glm::vec3 CCatmullRom::EvaluateSecondDerivative(const SplineSegment &segment, float t)
+{
+	return 6.0f * segment.d * t + 2.0f * segment.c;
+}
+
+// Rebuild the coefficient tables for every segment (including the one closing the loop) from the control points and upvectors
+void CCatmullRom::ComputeSegmentCoefficients()
 {
-	float t2 = t * t;
-	float t3 = t2 * t;
+	int M = (int)m_controlPoints.size();
+	bool bHasUpVectors = m_controlUpVectors.size() == m_controlPoints.size();
+
+	m_segments.resize(M);
+	m_upSegments.resize(bHasUpVectors ? M : 0);
+	for (int j = 0; j < M; j++)
+		ComputeSegmentCoefficients(j);
+}
 
-	glm::vec3 a = p1;
-	glm::vec3 b = 0.5f * (-p0 + p2);
-	glm::vec3 c = 0.5f * (2.0f*p0 - 5.0f*p1 + 4.0f*p2 - p3);
-	glm::vec3 d = 0.5f * (-p0 + 3.0f*p1 - 3.0f*p2 + p3);
+// Recompute the coefficients of segment j only, which depend on control points j - 1 to j + 2
+void CCatmullRom::ComputeSegmentCoefficients(int j)
+{
+	int M = (int)m_controlPoints.size();
+	int iPrev = ((j - 1) + M) % M;
+	int iNext = (j + 1) % M;
+	int iNextNext = (j + 2) % M;
 
-	return a + b * t + c * t2 + d * t3;
+	glm::vec3 p[4] = { m_controlPoints[iPrev], m_controlPoints[j], m_controlPoints[iNext], m_controlPoints[iNextNext] };
+	if (m_upSegments.empty()) {
+		SplineSegment unused;
+		m_computeSegments(p, NULL, m_segments[j], unused);
+	}
+	else {
+		glm::vec3 up[4] = { m_controlUpVectors[iPrev], m_controlUpVectors[j], m_controlUpVectors[iNext], m_controlUpVectors[iNextNext] };
+		m_computeSegments(p, up, m_segments[j], m_upSegments[j]);
+	}
+}
+
+// Fill in segment j's row of m_arcLengthTable, and return the length of the segment
+float CCatmullRom::ComputeArcLengthTable(int j)
+{
+	float *pRow = &m_arcLengthTable[j * (ARC_LENGTH_TABLE_SIZE + 1)];
+	float fSegmentLength = 0.0f;
+	pRow[0] = fSegmentLength;
+	for (int k = 0; k < ARC_LENGTH_TABLE_SIZE; k++) {
+		fSegmentLength += SegmentArcLength(j, (float)k / ARC_LENGTH_TABLE_SIZE, (float)(k + 1) / ARC_LENGTH_TABLE_SIZE);
+		pRow[k + 1] = fSegmentLength;
+	}
+	return fSegmentLength;
+}
+
+// Speed |P'(t)| on segment j
+float CCatmullRom::SegmentSpeed(int j, float t) const
+{
+	return glm::length(EvaluateDerivative(m_segments[j], t));
+}
+
+// Arc length of segment j between parameters t0 and t1, using 5 point Gauss-Legendre quadrature of |P'(t)|
+float CCatmullRom::SegmentArcLength(int j, float t0, float t1) const
+{
+	static const float nodes[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+	static const float weights[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+
+	float halfWidth = 0.5f * (t1 - t0);
+	float centre = 0.5f * (t1 + t0);
+
+	float fLength = 0.0f;
+	for (int k = 0; k < 5; k++)
+		fLength += weights[k] * SegmentSpeed(j, centre + halfWidth * nodes[k]);
+
+	return fLength * halfWidth;
+}
+
+// Find the interval [tLow, tHigh] of segment j's arc length table that contains fLength, and return a first guess for t by linear
+// interpolation within it.  fLengthAtLow receives the tabulated arc length at tLow.
+float CCatmullRom::BracketParameter(int j, float fLength, float &tLow, float &tHigh, float &fLengthAtLow) const
+{
+	vector<float>::const_iterator first = m_arcLengthTable.begin() + j * (ARC_LENGTH_TABLE_SIZE + 1);
+	vector<float>::const_iterator last = first + ARC_LENGTH_TABLE_SIZE + 1;
+
+	// The table is monotonic, so binary search for the bracketing interval [k, k + 1]
+	int k = (int)(std::upper_bound(first + 1, last, fLength) - first) - 1;
+	if (k >= ARC_LENGTH_TABLE_SIZE) {
+		tLow = tHigh = 1.0f;
+		fLengthAtLow = fLength;
+		return 1.0f;
+	}
+
+	tLow = (float)k / ARC_LENGTH_TABLE_SIZE;
+	fLengthAtLow = first[k];
+	float fIntervalLength = first[k + 1] - first[k];
+	if (fIntervalLength <= 0.0f) {
+		tHigh = tLow;
+		return tLow;
+	}
+
+	tHigh = (float)(k + 1) / ARC_LENGTH_TABLE_SIZE;
+	return tLow + (tHigh - tLow) * (fLength - first[k]) / fIntervalLength;
+}
+
+// Newton iterations on L(t) - fLength = 0, with L'(t) = |P'(t)|, keeping t within the bracket.  fLengthError is L(tLow) - fLength.
+float CCatmullRom::RefineParameter(int j, float t, float tLow, float tHigh, float fLengthError) const
+{
+	for (int iteration = 0; iteration < 2; iteration++) {
+		float fSpeed = SegmentSpeed(j, t);
+		if (fSpeed <= 0.0f)
+			break;
+		t -= (fLengthError + SegmentArcLength(j, tLow, t)) / fSpeed;
+		t = glm::clamp(t, tLow, tHigh);
+	}
+
+	return t;
+}
+
+// Invert the arc length table of segment j: return t such that the arc length from the start of the segment to t is fLength.
+// The table brackets the answer in one of ARC_LENGTH_TABLE_SIZE intervals, then a couple of Newton steps refine it.
+float CCatmullRom::ParameterAtLength(int j, float fLength) const
+{
+	float tLow, tHigh, fLengthAtLow;
+	float t = BracketParameter(j, fLength, tLow, tHigh, fLengthAtLow);
+	return RefineParameter(j, t, tLow, tHigh, fLengthAtLow - fLength);
 }
 
 void CCatmullRom::SetControlPoints()
@@ -43,25 +214,446 @@ void CCatmullRom::SetControlPoints()
 	m_controlPoints.push_back(glm::vec3(218, 0, -223));
 }
 
-// Determine lengths along the control points, which is the set of control points forming the closed curve
+// Replace the control points (and upvectors, which may be empty) and recompute the lengths along them.  No GL calls are made, so this can be used off the render thread.
+void CCatmullRom::SetControlPoints(const vector<glm::vec3> &controlPoints, const vector<glm::vec3> &controlUpVectors)
+{
+	m_controlPoints = controlPoints;
+	m_controlUpVectors = controlUpVectors;
+	ComputeLengthsAlongControlPoints();
+
+	// Anything sampled from the old control points is out of date
+	m_centrelinePoints.clear();
+	m_centrelineDistances.clear();
+	m_centrelineUpVectors.clear();
+	m_centrelineFrames.clear();
+	m_leftOffsetPoints.clear();
+	m_rightOffsetPoints.clear();
+	m_trackMesh.Clear();
+	m_trackCache.Close();
+	m_editing = false;
+}
+
+// Load a track from a text source file (see CTrackFile), along with everything sampled from it.  If filename.cache was baked from the 
+// same source and settings, the centreline, frames, arc length tables and track mesh are taken from it, memory mapped, rather than 
+// recomputed; otherwise they are built and the cache is rewritten.  Returns false, leaving the spline untouched, if the file can't be loaded.
+bool CCatmullRom::LoadTrack(const string &filename)
+{
+	CTrackFile track;
+	if (!track.Load(filename))
+		return false;
+
+	m_pathWidth = track.m_pathWidth;
+	m_controlPoints.clear();
+	SetParameterization(track.m_parameterization);
+	if (track.m_hasTessellation) {
+		if (track.m_adaptiveTessellation)
+			SetAdaptiveTessellation(track.m_maxAngle, track.m_maxChordError, track.m_maxSpacing);
+		else
+			SetUniformTessellation(track.m_numUniformSamples);
+	}
+
+	string cacheFilename = filename + ".cache";
+	unsigned long long hash = ComputeCacheHash(track.m_sourceHash);
+
+	// On a cache hit the arc length tables come from the cache, so don't compute them here
+	m_controlPoints = track.m_controlPoints;
+	m_controlUpVectors = track.m_controlUpVectors;
+	if (ReadTrackCache(cacheFilename, hash))
+		return true;
+
+	SetControlPoints(track.m_controlPoints, track.m_controlUpVectors);
+	Tessellate();
+	ComputeOffsetCurves();
+	BuildTrackMesh();
+	WriteTrackCache(cacheFilename, hash);
+	return true;
+}
+
+// The cache depends on the source and on every setting that changes what is baked from it
+unsigned long long CCatmullRom::ComputeCacheHash(unsigned long long sourceHash) const
+{
+	unsigned int version = TrackCacheHeader::VERSION;
+	int tableSize = ARC_LENGTH_TABLE_SIZE;
+
+	unsigned long long hash = HashFNV1a(&sourceHash, sizeof(sourceHash));
+	hash = HashFNV1a(&version, sizeof(version), hash);
+	hash = HashFNV1a(&tableSize, sizeof(tableSize), hash);
+	hash = HashFNV1a(&m_adaptiveTessellation, sizeof(m_adaptiveTessellation), hash);
+	hash = HashFNV1a(&m_numUniformSamples, sizeof(m_numUniformSamples), hash);
+	hash = HashFNV1a(&m_maxAngle, sizeof(m_maxAngle), hash);
+	hash = HashFNV1a(&m_maxChordError, sizeof(m_maxChordError), hash);
+	hash = HashFNV1a(&m_maxSpacing, sizeof(m_maxSpacing), hash);
+	hash = HashFNV1a(&m_chunkLength, sizeof(m_chunkLength), hash);
+	hash = HashFNV1a(m_parameterization, sizeof(m_parameterization), hash);
+	return hash;
+}
+
+// Size in bytes of one element of each section of the cache
+static void GetTrackCacheElementSizes(unsigned int indexSize, size_t sizes[TRACK_CACHE_NUM_SECTIONS])
+{
+	sizes[TRACK_CACHE_CENTRELINE_POINTS] = sizeof(glm::vec3);
+	sizes[TRACK_CACHE_CENTRELINE_DISTANCES] = sizeof(float);
+	sizes[TRACK_CACHE_CENTRELINE_UPVECTORS] = sizeof(glm::vec3);
+	sizes[TRACK_CACHE_CENTRELINE_FRAMES] = sizeof(TrackFrame);
+	sizes[TRACK_CACHE_SEGMENT_DISTANCES] = sizeof(float);
+	sizes[TRACK_CACHE_ARC_LENGTH_TABLE] = sizeof(float);
+	sizes[TRACK_CACHE_TRACK_VERTICES] = sizeof(TrackVertex);
+	sizes[TRACK_CACHE_TRACK_INDICES] = indexSize;
+	sizes[TRACK_CACHE_TRACK_CHUNKS] = sizeof(TrackChunk);
+}
+
+// Map the cache and, if it is intact and matches hash, take the sampled track from it.  The track mesh is used in place, so the 
+// mapping stays open until the control points change.
+bool CCatmullRom::ReadTrackCache(const string &filename, unsigned long long hash)
+{
+	m_trackMesh.Clear();
+	if (!m_trackCache.Open(filename))
+		return false;
+
+	const BYTE *pData = m_trackCache.GetData();
+	size_t size = m_trackCache.GetSize();
+	const TrackCacheHeader *pHeader = (const TrackCacheHeader*)pData;
+
+	bool bValid = size >= sizeof(TrackCacheHeader) && pHeader->magic == TrackCacheHeader::MAGIC && pHeader->version == TrackCacheHeader::VERSION && 
+		pHeader->vertexSize == sizeof(TrackVertex) && pHeader->frameSize == sizeof(TrackFrame) && pHeader->chunkSize == sizeof(TrackChunk) && 
+		(pHeader->indexSize == 2 || pHeader->indexSize == 4) && pHeader->hash == hash && pHeader->fileSize == size;
+
+	size_t elementSizes[TRACK_CACHE_NUM_SECTIONS];
+	GetTrackCacheElementSizes(bValid ? pHeader->indexSize : 4, elementSizes);
+	for (int i = 0; i < TRACK_CACHE_NUM_SECTIONS && bValid; i++) {
+		const TrackCacheSectionInfo &section = pHeader->sections[i];
+		bValid = section.offset <= size && section.count <= (size - section.offset) / elementSizes[i];
+	}
+
+	// The sections must also agree with each other and with the control points, since the hash only shows which track and 
+	// settings the file claims to be for
+	if (bValid) {
+		const TrackCacheSectionInfo *sections = pHeader->sections;
+		unsigned long long M = m_controlPoints.size();
+		unsigned long long numSamples = sections[TRACK_CACHE_CENTRELINE_POINTS].count;
+		unsigned long long numUpVectors = m_controlUpVectors.empty() ? 0 : numSamples;
+		bValid = sections[TRACK_CACHE_SEGMENT_DISTANCES].count == M + 1 && 
+			sections[TRACK_CACHE_ARC_LENGTH_TABLE].count == M * (ARC_LENGTH_TABLE_SIZE + 1) && 
+			numSamples > 0 && sections[TRACK_CACHE_CENTRELINE_DISTANCES].count == numSamples && 
+			sections[TRACK_CACHE_CENTRELINE_FRAMES].count == numSamples && sections[TRACK_CACHE_CENTRELINE_UPVECTORS].count == numUpVectors && 
+			pHeader->fullDetailIndexCount <= sections[TRACK_CACHE_TRACK_INDICES].count;
+	}
+
+	// RenderTrack draws straight from the chunk table, so every range at every level has to lie within the index buffer
+	if (bValid) {
+		const TrackChunk *pChunks = (const TrackChunk*)(pData + pHeader->sections[TRACK_CACHE_TRACK_CHUNKS].offset);
+		unsigned long long numIndices = pHeader->sections[TRACK_CACHE_TRACK_INDICES].count;
+		for (unsigned long long c = 0; c < pHeader->sections[TRACK_CACHE_TRACK_CHUNKS].count && bValid; c++) {
+			for (int l = 0; l < TrackChunk::NUM_LODS && bValid; l++)
+				bValid = (unsigned long long)pChunks[c].firstIndex[l] + pChunks[c].indexCount[l] <= numIndices;
+		}
+	}
+
+	// Finally the contents themselves, since the hash only covers the source and settings
+	if (bValid) {
+		unsigned long long contentHash = FNV_OFFSET_BASIS;
+		for (int i = 0; i < TRACK_CACHE_NUM_SECTIONS; i++)
+			contentHash = HashFNV1a(pData + pHeader->sections[i].offset, (size_t)pHeader->sections[i].count * elementSizes[i], contentHash);
+		bValid = contentHash == pHeader->contentHash;
+	}
+	if (!bValid) {
+		m_trackCache.Close();
+		return false;
+	}
+
+	#define TRACK_CACHE_ARRAY(type, section) ((const type*)(pData + pHeader->sections[section].offset))
+	#define TRACK_CACHE_COUNT(section) ((size_t)pHeader->sections[section].count)
+
+	// Small tables are copied; the segment coefficients are cheap to recompute from the control points
+	ComputeSegmentCoefficients();
+	m_distances.assign(TRACK_CACHE_ARRAY(float, TRACK_CACHE_SEGMENT_DISTANCES), 
+		TRACK_CACHE_ARRAY(float, TRACK_CACHE_SEGMENT_DISTANCES) + TRACK_CACHE_COUNT(TRACK_CACHE_SEGMENT_DISTANCES));
+	m_arcLengthTable.assign(TRACK_CACHE_ARRAY(float, TRACK_CACHE_ARC_LENGTH_TABLE), 
+		TRACK_CACHE_ARRAY(float, TRACK_CACHE_ARC_LENGTH_TABLE) + TRACK_CACHE_COUNT(TRACK_CACHE_ARC_LENGTH_TABLE));
+	m_centrelinePoints.assign(TRACK_CACHE_ARRAY(glm::vec3, TRACK_CACHE_CENTRELINE_POINTS), 
+		TRACK_CACHE_ARRAY(glm::vec3, TRACK_CACHE_CENTRELINE_POINTS) + TRACK_CACHE_COUNT(TRACK_CACHE_CENTRELINE_POINTS));
+	m_centrelineDistances.assign(TRACK_CACHE_ARRAY(float, TRACK_CACHE_CENTRELINE_DISTANCES), 
+		TRACK_CACHE_ARRAY(float, TRACK_CACHE_CENTRELINE_DISTANCES) + TRACK_CACHE_COUNT(TRACK_CACHE_CENTRELINE_DISTANCES));
+	m_centrelineUpVectors.assign(TRACK_CACHE_ARRAY(glm::vec3, TRACK_CACHE_CENTRELINE_UPVECTORS), 
+		TRACK_CACHE_ARRAY(glm::vec3, TRACK_CACHE_CENTRELINE_UPVECTORS) + TRACK_CACHE_COUNT(TRACK_CACHE_CENTRELINE_UPVECTORS));
+	m_centrelineFrames.assign(TRACK_CACHE_ARRAY(TrackFrame, TRACK_CACHE_CENTRELINE_FRAMES), 
+		TRACK_CACHE_ARRAY(TrackFrame, TRACK_CACHE_CENTRELINE_FRAMES) + TRACK_CACHE_COUNT(TRACK_CACHE_CENTRELINE_FRAMES));
+	ComputeOffsetCurves();
+
+	int M = (int)m_controlPoints.size();
+	m_segmentBoundsMin.resize(M);
+	m_segmentBoundsMax.resize(M);
+	for (int j = 0; j < M; j++)
+		ComputeSegmentBounds(j);
+	m_segmentGrid.Build(m_segmentBoundsMin, m_segmentBoundsMax);
+
+	// The track mesh, which is most of the file, is used straight from the mapping
+	m_trackMesh.Attach(TRACK_CACHE_ARRAY(TrackVertex, TRACK_CACHE_TRACK_VERTICES), (unsigned int)TRACK_CACHE_COUNT(TRACK_CACHE_TRACK_VERTICES), 
+		TRACK_CACHE_ARRAY(void, TRACK_CACHE_TRACK_INDICES), (unsigned int)TRACK_CACHE_COUNT(TRACK_CACHE_TRACK_INDICES), pHeader->indexSize, 
+		TRACK_CACHE_ARRAY(TrackChunk, TRACK_CACHE_TRACK_CHUNKS), (unsigned int)TRACK_CACHE_COUNT(TRACK_CACHE_TRACK_CHUNKS), pHeader->fullDetailIndexCount);
+
+	#undef TRACK_CACHE_ARRAY
+	#undef TRACK_CACHE_COUNT
+
+	return true;
+}
+
+// Bake the sampled track to filename.  Failing to write the cache (a read-only folder, say) only costs the next launch a rebuild.
+void CCatmullRom::WriteTrackCache(const string &filename, unsigned long long hash) const
+{
+	const vector<TrackChunk> &chunks = m_trackMesh.GetChunks();
+	const void *sectionData[TRACK_CACHE_NUM_SECTIONS] = {
+		m_centrelinePoints.empty() ? NULL : &m_centrelinePoints[0],
+		m_centrelineDistances.empty() ? NULL : &m_centrelineDistances[0],
+		m_centrelineUpVectors.empty() ? NULL : &m_centrelineUpVectors[0],
+		m_centrelineFrames.empty() ? NULL : &m_centrelineFrames[0],
+		m_distances.empty() ? NULL : &m_distances[0],
+		m_arcLengthTable.empty() ? NULL : &m_arcLengthTable[0],
+		m_trackMesh.GetVertexData(),
+		m_trackMesh.GetIndexData(),
+		chunks.empty() ? NULL : &chunks[0],
+	};
+	size_t sectionCounts[TRACK_CACHE_NUM_SECTIONS] = {
+		m_centrelinePoints.size(), m_centrelineDistances.size(), m_centrelineUpVectors.size(), m_centrelineFrames.size(), 
+		m_distances.size(), m_arcLengthTable.size(), m_trackMesh.GetVertexCount(), m_trackMesh.GetIndexCount(), chunks.size()
+	};
+	size_t elementSizes[TRACK_CACHE_NUM_SECTIONS];
+	GetTrackCacheElementSizes(m_trackMesh.GetIndexSize(), elementSizes);
+
+	TrackCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = TrackCacheHeader::MAGIC;
+	header.version = TrackCacheHeader::VERSION;
+	header.vertexSize = sizeof(TrackVertex);
+	header.frameSize = sizeof(TrackFrame);
+	header.chunkSize = sizeof(TrackChunk);
+	header.indexSize = m_trackMesh.GetIndexSize();
+	header.hash = hash;
+	header.contentHash = FNV_OFFSET_BASIS;
+	for (int i = 0; i < TRACK_CACHE_NUM_SECTIONS; i++) {
+		if (sectionCounts[i] > 0)
+			header.contentHash = HashFNV1a(sectionData[i], sectionCounts[i] * elementSizes[i], header.contentHash);
+	}
+	header.fullDetailIndexCount = m_trackMesh.GetFullDetailIndexCount();
+	header.pathWidth = m_pathWidth;
+
+	// Lay the sections out one after another on 16 byte boundaries
+	unsigned long long offset = sizeof(TrackCacheHeader);
+	for (int i = 0; i < TRACK_CACHE_NUM_SECTIONS; i++) {
+		offset = (offset + 15) & ~15ULL;
+		header.sections[i].offset = offset;
+		header.sections[i].count = sectionCounts[i];
+		offset += sectionCounts[i] * elementSizes[i];
+	}
+	header.fileSize = offset;
+
+	FILE *fp;
+	if (fopen_s(&fp, PlatformPath(filename).c_str(), "wb") != 0 || fp == NULL)
+		return;
+
+	static const BYTE padding[16] = { 0 };
+	bool bOk = fwrite(&header, sizeof(header), 1, fp) == 1;
+	unsigned long long written = sizeof(TrackCacheHeader);
+	for (int i = 0; i < TRACK_CACHE_NUM_SECTIONS && bOk; i++) {
+		bOk = fwrite(padding, 1, (size_t)(header.sections[i].offset - written), fp) == header.sections[i].offset - written;
+		size_t bytes = sectionCounts[i] * elementSizes[i];
+		if (bytes > 0)
+			bOk = bOk && fwrite(sectionData[i], 1, bytes, fp) == bytes;
+		written = header.sections[i].offset + bytes;
+	}
+	fclose(fp);
+
+	// Don't leave a half written cache behind
+	if (!bOk)
+		remove(PlatformPath(filename).c_str());
+}
+
+// Determine lengths along the curve through the control points, which is the set of control points forming the closed curve.
+// m_distances holds the arc length at the start of each segment, and m_arcLengthTable the arc length at ARC_LENGTH_TABLE_SIZE + 1 
+// evenly spaced parameter values within each segment, measured from the start of that segment.
 void CCatmullRom::ComputeLengthsAlongControlPoints()
 {
 	int M = (int)m_controlPoints.size();
 
+	m_distances.clear();
+	m_arcLengthTable.clear();
+	m_segmentBoundsMin.clear();
+	m_segmentBoundsMax.clear();
+	m_segmentGrid.Clear();
+	ComputeSegmentCoefficients();
+	if (M == 0)
+		return;
+
+	m_arcLengthTable.resize(M * (ARC_LENGTH_TABLE_SIZE + 1));
+	m_segmentBoundsMin.resize(M);
+	m_segmentBoundsMax.resize(M);
 	float fAccumulatedLength = 0.0f;
 	m_distances.push_back(fAccumulatedLength);
-	for (int i = 1; i < M; i++) {
-		fAccumulatedLength += glm::distance(m_controlPoints[i - 1], m_controlPoints[i]);
+	for (int j = 0; j < M; j++) {
+		fAccumulatedLength += ComputeArcLengthTable(j);
 		m_distances.push_back(fAccumulatedLength);
+		ComputeSegmentBounds(j);
+	}
+	m_segmentGrid.Build(m_segmentBoundsMin, m_segmentBoundsMax);
+}
+
+// Return the index j of the segment such that m_distances[j] <= fLength < m_distances[j + 1], or -1 if fLength is off the end.
+// m_distances is sorted, so a binary search keeps this O(log n) in the number of control points.
+int CCatmullRom::FindSegment(float fLength) const
+{
+	vector<float>::const_iterator it = std::upper_bound(m_distances.begin(), m_distances.end(), fLength);
+	if (it == m_distances.begin() || it == m_distances.end())
+		return -1;
+
+	return (int)(it - m_distances.begin()) - 1;
+}
+
+// Bounding box of segment j, from points at the arc length table's parameter values.  The cubic can bulge a little between them, 
+// so the box is padded by a fraction of the segment's length.
+void CCatmullRom::ComputeSegmentBounds(int j)
+{
+	glm::vec3 boundsMin = m_segments[j].a, boundsMax = m_segments[j].a;
+	for (int k = 1; k <= ARC_LENGTH_TABLE_SIZE; k++) {
+		glm::vec3 p = Evaluate(m_segments[j], (float)k / ARC_LENGTH_TABLE_SIZE);
+		boundsMin = glm::min(boundsMin, p);
+		boundsMax = glm::max(boundsMax, p);
+	}
+
+	float fPadding = 0.01f * m_arcLengthTable[j * (ARC_LENGTH_TABLE_SIZE + 1) + ARC_LENGTH_TABLE_SIZE];
+	m_segmentBoundsMin[j] = boundsMin - glm::vec3(fPadding);
+	m_segmentBoundsMax[j] = boundsMax + glm::vec3(fPadding);
+}
+
+// Closest point on segment j to p.  The best of the arc length table's parameter values starts Newton's method on (P(t) - p).P'(t) = 0, 
+// whose derivative is |P'(t)|^2 + (P(t) - p).P''(t); where that isn't positive, a plain gradient step is taken instead.
+float CCatmullRom::ProjectToSegment(int j, const glm::vec3 &p, float &t) const
+{
+	const SplineSegment &segment = m_segments[j];
+
+	float fBest = FLT_MAX;
+	for (int k = 0; k <= ARC_LENGTH_TABLE_SIZE; k++) {
+		glm::vec3 v = Evaluate(segment, (float)k / ARC_LENGTH_TABLE_SIZE) - p;
+		float f = glm::dot(v, v);
+		if (f < fBest) {
+			fBest = f;
+			t = (float)k / ARC_LENGTH_TABLE_SIZE;
+		}
+	}
+
+	for (int iteration = 0; iteration < 4; iteration++) {
+		glm::vec3 v = Evaluate(segment, t) - p;
+		glm::vec3 d1 = EvaluateDerivative(segment, t);
+		float g = glm::dot(v, d1);
+		float fSpeed2 = glm::dot(d1, d1);
+		float gDash = fSpeed2 + glm::dot(v, EvaluateSecondDerivative(segment, t));
+		if (gDash > 0.0f)
+			t -= g / gDash;
+		else if (fSpeed2 > 0.0f)
+			t -= g / fSpeed2;
+		t = glm::clamp(t, 0.0f, 1.0f);
+	}
+
+	glm::vec3 v = Evaluate(segment, t) - p;
+	return glm::dot(v, v);
+}
+
+// Search the grid in square rings of cells around the one containing p.  Nothing in ring r + 1 can be closer than r cells, so 
+// the search stops once the closest point found so far is within that.  Segments span several cells, so the few already tested 
+// are remembered and skipped, as are those whose bounding box is further away than the best so far.
+bool CCatmullRom::ProjectToTrack(const glm::vec3 &p, TrackProjection &projection) const
+{
+	if (m_segmentGrid.IsEmpty())
+		return false;
+
+	const int MAX_TESTED = 32;
+	int tested[MAX_TESTED];
+	int numTested = 0;
+
+	int cx, cz;
+	m_segmentGrid.FindCell(p, cx, cz);
+	int numCellsX = m_segmentGrid.GetNumCellsX(), numCellsZ = m_segmentGrid.GetNumCellsZ();
+	int maxRing = numCellsX > numCellsZ ? numCellsX : numCellsZ;
+	float fCellSize = m_segmentGrid.GetCellSize();
+
+	float fBest = FLT_MAX, tBest = 0.0f;
+	int jBest = -1;
+	for (int r = 0; r <= maxRing; r++) {
+		for (int z = cz - r; z <= cz + r; z++) {
+			if (z < 0 || z >= numCellsZ)
+				continue;
+
+			// Whole rows at the top and bottom of the ring, only the two ends of the rows in between
+			int xStep = (z == cz - r || z == cz + r) ? 1 : 2 * r;
+			for (int x = cx - r; x <= cx + r; x += xStep) {
+				if (x < 0 || x >= numCellsX)
+					continue;
+
+				const int *pItems;
+				int count;
+				m_segmentGrid.GetCell(x, z, pItems, count);
+				for (int i = 0; i < count; i++) {
+					int j = pItems[i];
+					bool bTested = false;
+					for (int k = 0; k < numTested && !bTested; k++)
+						bTested = tested[k] == j;
+					if (bTested)
+						continue;
+					if (numTested < MAX_TESTED)
+						tested[numTested++] = j;
+
+					glm::vec3 closest = glm::clamp(p, m_segmentBoundsMin[j], m_segmentBoundsMax[j]);
+					if (glm::dot(closest - p, closest - p) >= fBest)
+						continue;
+
+					float t;
+					float f = ProjectToSegment(j, p, t);
+					if (f < fBest) {
+						fBest = f;
+						tBest = t;
+						jBest = j;
+					}
+				}
+			}
+		}
+
+		if (jBest >= 0 && fBest <= (r * fCellSize) * (r * fCellSize))
+			break;
+	}
+
+	// Arc length to tBest from the table, plus the part of the last interval
+	int k = (int)(tBest * ARC_LENGTH_TABLE_SIZE);
+	if (k >= ARC_LENGTH_TABLE_SIZE)
+		k = ARC_LENGTH_TABLE_SIZE - 1;
+	float fLength = m_arcLengthTable[jBest * (ARC_LENGTH_TABLE_SIZE + 1) + k] + SegmentArcLength(jBest, (float)k / ARC_LENGTH_TABLE_SIZE, tBest);
+
+	projection.segment = jBest;
+	projection.distance = m_distances[jBest] + fLength;
+	projection.position = Evaluate(m_segments[jBest], tBest);
+
+	// Offsets in the track frame, or in one built from the tangent and upvector if the centreline hasn't been sampled yet
+	TrackFrame frame;
+	if (!SampleFrame(projection.distance, frame)) {
+		SplineSample sample;
+		SampleSegment(jBest, projection.distance, sample);
+		frame.T = sample.tangent;
+		frame.N = glm::normalize(glm::cross(sample.tangent, sample.up));
+		frame.B = glm::cross(frame.N, frame.T);
 	}
+	projection.lateral = glm::dot(p - projection.position, frame.N);
+	projection.height = glm::dot(p - projection.position, frame.B);
 
-	// Get the distance from the last point to the first
-	//fAccumulatedLength += glm::distance(m_controlPoints[M - 1], m_controlPoints[0]);
-	//m_distances.push_back(fAccumulatedLength);
+	return true;
+}
+
+// The current length along the curve for a distance d, handling the case where we've looped around the track
+float CCatmullRom::WrapDistance(float d) const
+{
+	float fTotalLength = m_distances.back();
+	return d - (int)(d / fTotalLength) * fTotalLength;
 }
 
-// Return the point (and upvector, if control upvectors provided) based on a distance d along the control polygon
-bool CCatmullRom::Sample(float d, glm::vec3 &p, glm::vec3 &up)
+// Return the point (and upvector, if control upvectors provided) based on a distance d along the curve
+bool CCatmullRom::Sample(float d, glm::vec3 &p, glm::vec3 &up) const
 {
 	if (d < 0)
 		return false;
@@ -70,87 +662,925 @@ bool CCatmullRom::Sample(float d, glm::vec3 &p, glm::vec3 &up)
 	if (M == 0)
 		return false;
 
+	float fLength = WrapDistance(d);
 
-	float fTotalLength = m_distances[m_distances.size() - 1];
+	// Find the current segment
+	int j = FindSegment(fLength);
+	if (j == -1)
+		return false;
 
-	// The the current length along the control polygon; handle the case where we've looped around the track
-	float fLength = d - (int)(d / fTotalLength) * fTotalLength;
+	return SampleSegment(j, fLength, p, up);
+}
 
-	// Find the current segment
-	int j = -1;
-	for (int i = 0; i < (int)m_distances.size(); i++) {
-		if (fLength >= m_distances[i] && fLength < m_distances[i + 1]) {
-			j = i; // found it!
-			break;
-		}
-	}
+bool CCatmullRom::Sample(float d, glm::vec3 &p) const
+{
+	glm::vec3 up;
+	return Sample(d, p, up);
+}
+
+// Return the point, tangent, normal and curvature based on a distance d along the curve
+bool CCatmullRom::Sample(float d, SplineSample &sample) const
+{
+	if (d < 0 || m_distances.size() < 2)
+		return false;
 
+	float fLength = WrapDistance(d);
+
+	int j = FindSegment(fLength);
 	if (j == -1)
 		return false;
 
-	// Interpolate on current segment -- get t
-	float fSegmentLength = m_distances[j + 1] - m_distances[j];
-	float t = (fLength - m_distances[j]) / fSegmentLength;
+	return SampleSegment(j, fLength, sample);
+}
 
-	// Get the indices of the four points along the control polygon for the current segment
-	int iPrev = ((j - 1) + M) % M;
-	int iCur = j;
-	int iNext = (j + 1) % M;
-	int iNextNext = (j + 2) % M;
+// Return the point, tangent, normal and curvature at a length fLength along one lap, which the caller has already located on segment j.
+// These come from the first and second derivatives of the segment's cubic, so no neighbouring samples are needed.
+bool CCatmullRom::SampleSegment(int j, float fLength, SplineSample &sample) const
+{
+	float t = ParameterAtLength(j, fLength - m_distances[j]);
+
+	const SplineSegment &segment = m_segments[j];
+	glm::vec3 firstDerivative = EvaluateDerivative(segment, t);
+	glm::vec3 secondDerivative = EvaluateSecondDerivative(segment, t);
+
+	float fSpeed = glm::length(firstDerivative);
+	if (fSpeed <= 0.0f)
+		return false;
 
-	// Interpolate to get the point (and upvector)
-	p = Interpolate(m_controlPoints[iPrev], m_controlPoints[iCur], m_controlPoints[iNext], m_controlPoints[iNextNext], t);
-	if (m_controlUpVectors.size() == m_controlPoints.size())
-		up = glm::normalize(Interpolate(m_controlUpVectors[iPrev], m_controlUpVectors[iCur], m_controlUpVectors[iNext], m_controlUpVectors[iNextNext], t));
+	sample.position = Evaluate(segment, t);
+	sample.tangent = firstDerivative / fSpeed;
+	sample.curvature = glm::length(glm::cross(firstDerivative, secondDerivative)) / (fSpeed * fSpeed * fSpeed);
+
+	// The principal normal is the part of the second derivative perpendicular to the tangent
+	glm::vec3 normal = secondDerivative - glm::dot(secondDerivative, sample.tangent) * sample.tangent;
+	float fNormalLength = glm::length(normal);
+	sample.normal = fNormalLength > 1e-6f ? normal / fNormalLength : glm::vec3(0.0f);
+
+	if (!m_upSegments.empty())
+		sample.up = glm::normalize(Evaluate(m_upSegments[j], t));
+	else
+		sample.up = glm::vec3(0.0f, 1.0f, 0.0f);
 
 	return true;
 }
 
-// Sample a set of control points using an open Catmull-Rom spline, to produce a set of iNumSamples that are (roughly) equally spaced
-void CCatmullRom::UniformlySampleControlPoints(int numSamples)
+// Return the point (and upvector) at a length fLength along one lap, which the caller has already located on segment j
+bool CCatmullRom::SampleSegment(int j, float fLength, glm::vec3 &p, glm::vec3 &up) const
+{
+	// Interpolate on current segment -- get t from the arc length along it
+	float t = ParameterAtLength(j, fLength - m_distances[j]);
+
+	// Evaluate the cached cubic for the current segment to get the point (and upvector)
+	p = Evaluate(m_segments[j], t);
+	if (!m_upSegments.empty())
+		up = glm::normalize(Evaluate(m_upSegments[j], t));
+
+	return true;
+}
+
+#ifdef CATMULLROM_SSE2
+// The coefficients of four segments, transposed so that each register holds one component of one coefficient for all four lanes
+struct SegmentsSSE
+{
+	__m128 ax, ay, az, bx, by, bz, cx, cy, cz, dx, dy, dz;
+};
+
+static inline void GatherSSE(const SplineSegment *s[4], SegmentsSSE &g)
+{
+	g.ax = _mm_set_ps(s[3]->a.x, s[2]->a.x, s[1]->a.x, s[0]->a.x);
+	g.ay = _mm_set_ps(s[3]->a.y, s[2]->a.y, s[1]->a.y, s[0]->a.y);
+	g.az = _mm_set_ps(s[3]->a.z, s[2]->a.z, s[1]->a.z, s[0]->a.z);
+	g.bx = _mm_set_ps(s[3]->b.x, s[2]->b.x, s[1]->b.x, s[0]->b.x);
+	g.by = _mm_set_ps(s[3]->b.y, s[2]->b.y, s[1]->b.y, s[0]->b.y);
+	g.bz = _mm_set_ps(s[3]->b.z, s[2]->b.z, s[1]->b.z, s[0]->b.z);
+	g.cx = _mm_set_ps(s[3]->c.x, s[2]->c.x, s[1]->c.x, s[0]->c.x);
+	g.cy = _mm_set_ps(s[3]->c.y, s[2]->c.y, s[1]->c.y, s[0]->c.y);
+	g.cz = _mm_set_ps(s[3]->c.z, s[2]->c.z, s[1]->c.z, s[0]->c.z);
+	g.dx = _mm_set_ps(s[3]->d.x, s[2]->d.x, s[1]->d.x, s[0]->d.x);
+	g.dy = _mm_set_ps(s[3]->d.y, s[2]->d.y, s[1]->d.y, s[0]->d.y);
+	g.dz = _mm_set_ps(s[3]->d.z, s[2]->d.z, s[1]->d.z, s[0]->d.z);
+}
+
+// Evaluate ((d t + c) t + b) t + a in each lane
+static inline void EvaluateSSE(const SegmentsSSE &g, const __m128 &t, __m128 &x, __m128 &y, __m128 &z)
+{
+	x = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(g.dx, t), g.cx), t), g.bx), t), g.ax);
+	y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(g.dy, t), g.cy), t), g.by), t), g.ay);
+	z = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(g.dz, t), g.cz), t), g.bz), t), g.az);
+}
+
+// Evaluate the derivative (3d t + 2c) t + b in each lane
+static inline void EvaluateDerivativeSSE(const SegmentsSSE &g, const __m128 &t, __m128 &x, __m128 &y, __m128 &z)
+{
+	__m128 three = _mm_set1_ps(3.0f);
+	__m128 two = _mm_set1_ps(2.0f);
+	x = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(three, g.dx), t), _mm_mul_ps(two, g.cx)), t), g.bx);
+	y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(three, g.dy), t), _mm_mul_ps(two, g.cy)), t), g.by);
+	z = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(three, g.dz), t), _mm_mul_ps(two, g.cz)), t), g.bz);
+}
+
+static inline __m128 LengthSSE(const __m128 &x, const __m128 &y, const __m128 &z)
+{
+	return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+}
+
+static inline __m128 SpeedSSE(const SegmentsSSE &g, const __m128 &t)
 {
-	glm::vec3 p, up;
+	__m128 x, y, z;
+	EvaluateDerivativeSSE(g, t, x, y, z);
+	return LengthSSE(x, y, z);
+}
+
+// Normalise four vectors in place, one per lane
+static inline void NormaliseSSE(__m128 &x, __m128 &y, __m128 &z)
+{
+	__m128 length = LengthSSE(x, y, z);
+	x = _mm_div_ps(x, length);
+	y = _mm_div_ps(y, length);
+	z = _mm_div_ps(z, length);
+}
+
+// Four lanes of the Newton refinement in ParameterAtLength: t -= (L(tLow) + integral of |P'| over [tLow, t] - target) / |P'(t)|
+static inline __m128 RefineParameterSSE(const SegmentsSSE &g, __m128 t, const __m128 &tLow, const __m128 &tHigh, const __m128 &fLengthError)
+{
+	static const float nodes[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+	static const float weights[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+	__m128 half = _mm_set1_ps(0.5f);
+
+	for (int iteration = 0; iteration < 2; iteration++) {
+		__m128 halfWidth = _mm_mul_ps(half, _mm_sub_ps(t, tLow));
+		__m128 centre = _mm_mul_ps(half, _mm_add_ps(t, tLow));
+
+		__m128 integral = _mm_setzero_ps();
+		for (int k = 0; k < 5; k++)
+			integral = _mm_add_ps(integral, _mm_mul_ps(_mm_set1_ps(weights[k]), SpeedSSE(g, _mm_add_ps(centre, _mm_mul_ps(halfWidth, _mm_set1_ps(nodes[k]))))));
+		integral = _mm_mul_ps(integral, halfWidth);
+
+		// Lanes where the curve has zero speed keep their current guess
+		__m128 speed = SpeedSSE(g, t);
+		__m128 moving = _mm_cmpgt_ps(speed, _mm_setzero_ps());
+		__m128 step = _mm_div_ps(_mm_add_ps(fLengthError, integral), speed);
+		t = _mm_sub_ps(t, _mm_and_ps(moving, step));
+		t = _mm_min_ps(_mm_max_ps(t, tLow), tHigh);
+	}
+
+	return t;
+}
+#endif
+
+// Sample many distances at once.  The segment search is scalar; the arc length inversion and cubic evaluation run four samples 
+// per instruction with SSE2, falling back to scalar code for the remainder (and on platforms without SSE2).  The distances are 
+// taken SAMPLE_BATCH_LANES at a time, with the per sample working state on the stack, so a call makes no allocations.
+void CCatmullRom::SampleBatch(const float *d, size_t n, const SplineBatchOutput &out) const
+{
+	static const size_t SAMPLE_BATCH_LANES = 64;	// A multiple of 4, so only the last batch has a scalar remainder
+
+	if (m_distances.size() < 2 || n == 0)
+		return;
+
+	float fTotalLength = m_distances.back();
+	bool bHasUpVectors = !m_upSegments.empty();
+
+	int segments[SAMPLE_BATCH_LANES];
+	float parameters[SAMPLE_BATCH_LANES], tLows[SAMPLE_BATCH_LANES], tHighs[SAMPLE_BATCH_LANES], lengthErrors[SAMPLE_BATCH_LANES];
 
-	// Compute the lengths of each segment along the control polygon, and the total length
+	for (size_t base = 0; base < n; base += SAMPLE_BATCH_LANES) {
+		size_t count = n - base < SAMPLE_BATCH_LANES ? n - base : SAMPLE_BATCH_LANES;
+
+		// Find the segment for each distance, and bracket its parameter in the arc length table
+		for (size_t k = 0; k < count; k++) {
+			float fLength = fmodf(d[base + k], fTotalLength);
+			if (fLength < 0.0f)
+				fLength += fTotalLength;
+
+			int j = FindSegment(fLength);
+			if (j == -1)
+				j = (int)m_distances.size() - 2;	// Rounding put fLength on the very end of the lap
+
+			float fSegmentLength = fLength - m_distances[j];
+			float fLengthAtLow;
+			segments[k] = j;
+			parameters[k] = BracketParameter(j, fSegmentLength, tLows[k], tHighs[k], fLengthAtLow);
+			lengthErrors[k] = fLengthAtLow - fSegmentLength;
+		}
+
+		size_t k = 0;
+
+#ifdef CATMULLROM_SSE2
+		for (; k + 4 <= count; k += 4) {
+			size_t i = base + k;
+			const SplineSegment *s[4] = { &m_segments[segments[k]], &m_segments[segments[k + 1]], &m_segments[segments[k + 2]], &m_segments[segments[k + 3]] };
+			SegmentsSSE g;
+			GatherSSE(s, g);
+
+			__m128 t = RefineParameterSSE(g, _mm_loadu_ps(&parameters[k]), _mm_loadu_ps(&tLows[k]), _mm_loadu_ps(&tHighs[k]), _mm_loadu_ps(&lengthErrors[k]));
+			__m128 x, y, z;
+
+			if (out.px) {
+				EvaluateSSE(g, t, x, y, z);
+				_mm_storeu_ps(out.px + i, x);
+				_mm_storeu_ps(out.py + i, y);
+				_mm_storeu_ps(out.pz + i, z);
+			}
+
+			if (out.tx) {
+				EvaluateDerivativeSSE(g, t, x, y, z);
+				NormaliseSSE(x, y, z);
+				_mm_storeu_ps(out.tx + i, x);
+				_mm_storeu_ps(out.ty + i, y);
+				_mm_storeu_ps(out.tz + i, z);
+			}
+
+			if (out.ux) {
+				if (bHasUpVectors) {
+					const SplineSegment *u[4] = { &m_upSegments[segments[k]], &m_upSegments[segments[k + 1]], &m_upSegments[segments[k + 2]], &m_upSegments[segments[k + 3]] };
+					SegmentsSSE gu;
+					GatherSSE(u, gu);
+					EvaluateSSE(gu, t, x, y, z);
+					NormaliseSSE(x, y, z);
+				} else {
+					x = _mm_setzero_ps();
+					y = _mm_set1_ps(1.0f);
+					z = _mm_setzero_ps();
+				}
+				_mm_storeu_ps(out.ux + i, x);
+				_mm_storeu_ps(out.uy + i, y);
+				_mm_storeu_ps(out.uz + i, z);
+			}
+		}
+#endif
+
+		// Scalar path for the remaining samples
+		for (; k < count; k++) {
+			size_t i = base + k;
+			const SplineSegment &segment = m_segments[segments[k]];
+			float t = RefineParameter(segments[k], parameters[k], tLows[k], tHighs[k], lengthErrors[k]);
+
+			if (out.px) {
+				glm::vec3 p = Evaluate(segment, t);
+				out.px[i] = p.x;
+				out.py[i] = p.y;
+				out.pz[i] = p.z;
+			}
+
+			if (out.tx) {
+				glm::vec3 tangent = glm::normalize(EvaluateDerivative(segment, t));
+				out.tx[i] = tangent.x;
+				out.ty[i] = tangent.y;
+				out.tz[i] = tangent.z;
+			}
+
+			if (out.ux) {
+				glm::vec3 up = bHasUpVectors ? glm::normalize(Evaluate(m_upSegments[segments[k]], t)) : glm::vec3(0.0f, 1.0f, 0.0f);
+				out.ux[i] = up.x;
+				out.uy[i] = up.y;
+				out.uz[i] = up.z;
+			}
+		}
+	}
+}
+
+// Sample a set of control points using a closed Catmull-Rom spline, to produce a set of iNumSamples that are equally spaced in arc length
+void CCatmullRom::UniformlySampleControlPoints(int numSamples)
+{
+	// Compute the arc length of each segment along the curve, and the total length
 	ComputeLengthsAlongControlPoints();
 	float fTotalLength = m_distances[m_distances.size() - 1];
 
-	// The spacing will be based on the control polygon
+	// Sample inverts the arc length tables, so a single pass gives equidistant points
 	float fSpacing = fTotalLength / numSamples;
 
-	// Call PointAt to sample the spline, to generate the points
-	for (int i = 0; i < numSamples; i++) 
-	{
-		Sample(i * fSpacing, p, up);
-		m_centrelinePoints.push_back(p);
-		if (m_controlUpVectors.size() > 0)
-			m_centrelineUpVectors.push_back(up);
+	bool bHasUpVectors = m_controlUpVectors.size() > 0;
+	m_centrelinePoints.resize(numSamples);
+	m_centrelineDistances.resize(numSamples);
+	m_centrelineUpVectors.resize(bHasUpVectors ? numSamples : 0);
+	ParallelFor(0, numSamples, 1024, [&](int first, int last) {
+		glm::vec3 p, up;
+		for (int i = first; i < last; i++) {
+			Sample(i * fSpacing, p, up);
+			m_centrelinePoints[i] = p;
+			m_centrelineDistances[i] = i * fSpacing;
+			if (bHasUpVectors)
+				m_centrelineUpVectors[i] = up;
+		}
+	});
+
+	ComputeCentrelineFrames();
+}
+
+// Build a rotation minimising frame at every centreline point by parallel transporting the up vector B along the curve with the 
+// double reflection method (Wang et al., "Computation of rotation minimizing frames", 2008).  Unlike crossing the tangent with a 
+// fixed world up, this stays well defined on vertical sections and through loops.  If control upvectors were given, they set B 
+// wherever they are not parallel to the tangent, so the track can be banked.  The twist left over after going once around the 
+// closed loop is spread evenly along it so the frames meet up at the start.
+void CCatmullRom::ComputeCentrelineFrames()
+{
+	int M = (int)m_centrelinePoints.size();
+	m_centrelineFrames.resize(M);
+	if (M == 0)
+		return;
+
+	// Analytic tangents at the centreline points
+	ParallelFor(0, M, 1024, [&](int first, int last) {
+		SplineSample sample;
+		for (int i = first; i < last; i++) {
+			Sample(m_centrelineDistances[i], sample);
+			m_centrelineFrames[i].T = sample.tangent;
+		}
+	});
+
+	bool bHasUpVectors = m_centrelineUpVectors.size() == m_centrelinePoints.size();
+	glm::vec3 up0 = bHasUpVectors ? m_centrelineUpVectors[0] : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 T0 = m_centrelineFrames[0].T;
+
+	// Initial frame from the up vector; pick another reference if the track starts out vertical
+	glm::vec3 N = glm::cross(T0, up0);
+	if (glm::length(N) < 1e-4f)
+		N = glm::cross(T0, glm::vec3(1.0f, 0.0f, 0.0f));
+	N = glm::normalize(N);
+	glm::vec3 B = glm::cross(N, T0);
+
+	vector<glm::vec3> binormals(M + 1);
+	binormals[0] = B;
+	// Each frame is transported from the one before, so this part is serial
+	for (int i = 0; i < M; i++)
+		binormals[i + 1] = TransportBinormal(i, (i + 1) % M, binormals[i]);
+
+	// binormals[M] is the start frame transported once around the loop; measure its twist about T0 relative to binormals[0]
+	glm::vec3 N0 = glm::cross(T0, binormals[0]);
+	float fTwist = atan2f(glm::dot(binormals[M], N0), glm::dot(binormals[M], binormals[0]));
+
+	ParallelFor(0, M, 1024, [&](int first, int last) {
+		for (int i = first; i < last; i++) {
+			TrackFrame &frame = m_centrelineFrames[i];
+			frame.B = glm::rotate(binormals[i], -glm::degrees(fTwist) * i / M, frame.T);
+			frame.N = glm::cross(frame.T, frame.B);
+		}
+	});
+}
+
+// Carry the binormal b at centreline point i on to point iNext, using the tangents already in m_centrelineFrames.  The double 
+// reflection first reflects across the plane bisecting the two points, then across the plane that maps the reflected tangent onto 
+// the next one.  Where there are control upvectors that aren't parallel to the tangent, they take over, to bank the track.
+glm::vec3 CCatmullRom::TransportBinormal(int i, int iNext, const glm::vec3 &b) const
+{
+	const glm::vec3 &t0 = m_centrelineFrames[i].T;
+	const glm::vec3 &t1 = m_centrelineFrames[iNext].T;
+	glm::vec3 v1 = m_centrelinePoints[iNext] - m_centrelinePoints[i];
+	glm::vec3 r = b;
+
+	float c1 = glm::dot(v1, v1);
+	if (c1 > 0.0f) {
+		glm::vec3 rL = r - (2.0f / c1) * glm::dot(v1, r) * v1;
+		glm::vec3 tL = t0 - (2.0f / c1) * glm::dot(v1, t0) * v1;
+		glm::vec3 v2 = t1 - tL;
+		float c2 = glm::dot(v2, v2);
+		r = c2 > 0.0f ? rL - (2.0f / c2) * glm::dot(v2, rL) * v2 : rL;
+	}
+
+	if (m_centrelineUpVectors.size() == m_centrelinePoints.size()) {
+		glm::vec3 up = m_centrelineUpVectors[iNext] - glm::dot(m_centrelineUpVectors[iNext], t1) * t1;
+		if (glm::length(up) > 1e-4f)
+			r = up;
 	}
 
-	// Repeat once more for truly equidistant points
-	m_controlPoints = m_centrelinePoints;
-	m_controlUpVectors = m_centrelineUpVectors;
+	return glm::normalize(r - glm::dot(r, t1) * t1);
+}
+
+// Recompute the frames of the count centreline points from first on (wrapping around the loop), whose positions and tangents have 
+// changed, by transporting the frame of the point before them.  Whatever twist that leaves against the unchanged frame after them 
+// is spread evenly across them, so the rest of the table can stay as it is.
+void CCatmullRom::UpdateCentrelineFrames(int first, int count)
+{
+	int M = (int)m_centrelinePoints.size();
+	if (count >= M - 1) {
+		ComputeCentrelineFrames();
+		return;
+	}
+
+	int i = (first - 1 + M) % M;
+	glm::vec3 b = m_centrelineFrames[i].B;
+	for (int k = 0; k < count; k++) {
+		int iNext = (first + k) % M;
+		b = TransportBinormal(i, iNext, b);
+		m_centrelineFrames[iNext].B = b;
+		i = iNext;
+	}
+
+	const TrackFrame &after = m_centrelineFrames[(first + count) % M];
+	b = TransportBinormal(i, (first + count) % M, b);
+	float fTwist = atan2f(glm::dot(b, after.N), glm::dot(b, after.B));
+
+	for (int k = 0; k < count; k++) {
+		TrackFrame &frame = m_centrelineFrames[(first + k) % M];
+		frame.B = glm::rotate(frame.B, -glm::degrees(fTwist) * (k + 1) / (count + 1), frame.T);
+		frame.N = glm::cross(frame.T, frame.B);
+	}
+}
+
+// Return the track frame at a distance d along the curve, by interpolating between the two nearest entries of m_centrelineFrames
+bool CCatmullRom::SampleFrame(float d, TrackFrame &frame) const
+{
+	if (d < 0 || m_centrelineFrames.empty())
+		return false;
+
+	float fLength = WrapDistance(d);
+
+	int M = (int)m_centrelineFrames.size();
+	int i = (int)(std::upper_bound(m_centrelineDistances.begin(), m_centrelineDistances.end(), fLength) - m_centrelineDistances.begin()) - 1;
+	if (i < 0)
+		i = 0;
+	int iNext = (i + 1) % M;
+
+	float fStart = m_centrelineDistances[i];
+	float fEnd = i + 1 < M ? m_centrelineDistances[iNext] : GetTotalLength();
+	float w = fEnd > fStart ? (fLength - fStart) / (fEnd - fStart) : 0.0f;
+
+	// Normalised lerp, then re-orthonormalise about the interpolated tangent
+	const TrackFrame &a = m_centrelineFrames[i];
+	const TrackFrame &b = m_centrelineFrames[iNext];
+	frame.T = glm::normalize(glm::mix(a.T, b.T, w));
+	glm::vec3 B = glm::mix(a.B, b.B, w);
+	frame.B = glm::normalize(B - glm::dot(B, frame.T) * frame.T);
+	frame.N = glm::cross(frame.T, frame.B);
+
+	return true;
+}
+
+// Use numSamples equally spaced centreline points (the default, with 500).  A closed centreline needs at least 3.
+void CCatmullRom::SetUniformTessellation(int numSamples)
+{
+	m_adaptiveTessellation = false;
+	m_numUniformSamples = numSamples < 3 ? 3 : numSamples;
+}
+
+// Place centreline points only where they are needed: an interval is split while the tangent or upvector turns by more than fMaxAngle 
+// degrees across it, or the curve strays more than fMaxChordError from the straight line between its ends.  No interval is 
+// longer than fMaxSpacing, which bounds how far the frame table is interpolated.  Out of range tolerances are clamped: the angle 
+// to MIN_TESSELLATION_ANGLE, the chord error to 0 and the spacing to MIN_TESSELLATION_SPACING, since any of them at or below zero 
+// would split every interval down to the recursion limit or divide the lap into infinitely many intervals.
+void CCatmullRom::SetAdaptiveTessellation(float fMaxAngle, float fMaxChordError, float fMaxSpacing)
+{
+	m_adaptiveTessellation = true;
+	m_maxAngle = fMaxAngle > MIN_TESSELLATION_ANGLE ? fMaxAngle : MIN_TESSELLATION_ANGLE;
+	m_maxChordError = fMaxChordError > 0.0f ? fMaxChordError : 0.0f;
+	m_maxSpacing = fMaxSpacing > MIN_TESSELLATION_SPACING ? fMaxSpacing : MIN_TESSELLATION_SPACING;
+}
+
+// Sample the centreline (points, distances, upvectors and frames) from the current control points with the current tessellation setting
+void CCatmullRom::Tessellate()
+{
+	if (m_adaptiveTessellation)
+		AdaptivelySampleControlPoints(m_maxAngle, m_maxChordError, m_maxSpacing);
+	else
+		UniformlySampleControlPoints(m_numUniformSamples);
+}
+
+// Sample the control points adaptively (see SetAdaptiveTessellation).  The lap is first cut into equal intervals no longer than 
+// fMaxSpacing, then each interval is bisected in arc length until it passes both tolerances, so straights end up with a few long 
+// intervals and hairpins with many short ones.
+void CCatmullRom::AdaptivelySampleControlPoints(float fMaxAngle, float fMaxChordError, float fMaxSpacing)
+{
+	ComputeLengthsAlongControlPoints();
+	float fTotalLength = m_distances[m_distances.size() - 1];
+	bool bHasUpVectors = m_controlUpVectors.size() > 0;
+
+	float fCosMaxAngle = cosf(glm::radians(fMaxAngle));
+	int numIntervals = (int)ceilf(fTotalLength / fMaxSpacing);
+	if (numIntervals < 3)
+		numIntervals = 3;
+
+	// The intervals are independent, so they are split into groups that are subdivided in parallel, each into its own lists, 
+	// which are then joined in order.  The result is the same however the intervals are grouped.
+	int numGroups = 4 * GetParallelThreadCount();
+	if (numGroups > numIntervals)
+		numGroups = numIntervals;
+	vector<vector<glm::vec3> > groupPoints(numGroups), groupUpVectors(numGroups);
+	vector<vector<float> > groupDistances(numGroups);
+
+	ParallelFor(0, numGroups, 1, [&](int firstGroup, int lastGroup) {
+		for (int g = firstGroup; g < lastGroup; g++) {
+			int first = (int)((long long)numIntervals * g / numGroups);
+			int last = (int)((long long)numIntervals * (g + 1) / numGroups);
+
+			SplineSample start, end;
+			Sample(fTotalLength * first / numIntervals, start);
+			for (int i = first; i < last; i++) {
+				float d0 = fTotalLength * i / numIntervals;
+				float d1 = fTotalLength * (i + 1) / numIntervals;
+				Sample(i + 1 < numIntervals ? d1 : 0.0f, end);
+
+				groupPoints[g].push_back(start.position);
+				groupDistances[g].push_back(d0);
+				if (bHasUpVectors)
+					groupUpVectors[g].push_back(start.up);
+				SubdivideInterval(d0, start, d1, end, fCosMaxAngle, fMaxChordError, 0, groupPoints[g], groupDistances[g], groupUpVectors[g]);
+
+				start = end;
+			}
+		}
+	});
+
 	m_centrelinePoints.clear();
+	m_centrelineDistances.clear();
 	m_centrelineUpVectors.clear();
-	m_distances.clear();
-	ComputeLengthsAlongControlPoints();
-	fTotalLength = m_distances[m_distances.size() - 1];
-	fSpacing = fTotalLength / numSamples;
-	for (int i = 0; i < numSamples; i++) {
-		Sample(i * fSpacing, p, up);
-		m_centrelinePoints.push_back(p);
-		if (m_controlUpVectors.size() > 0)
-			m_centrelineUpVectors.push_back(up);
+	for (int g = 0; g < numGroups; g++) {
+		m_centrelinePoints.insert(m_centrelinePoints.end(), groupPoints[g].begin(), groupPoints[g].end());
+		m_centrelineDistances.insert(m_centrelineDistances.end(), groupDistances[g].begin(), groupDistances[g].end());
+		m_centrelineUpVectors.insert(m_centrelineUpVectors.end(), groupUpVectors[g].begin(), groupUpVectors[g].end());
 	}
+
+	ComputeCentrelineFrames();
 }
 
-void CCatmullRom::CreateCentreline()
+// Append the centreline points strictly inside (d0, d1) needed to meet the tolerances to points, distances and upVectors, in order of distance
+void CCatmullRom::SubdivideInterval(float d0, const SplineSample &s0, float d1, const SplineSample &s1, float fCosMaxAngle, float fMaxChordError, int depth, 
+	vector<glm::vec3> &points, vector<float> &distances, vector<glm::vec3> &upVectors) const
 {
-	// Call Set Control Points
-	SetControlPoints();
+	static const int MAX_DEPTH = 16;
+
+	// The midpoint and quarter points catch S bends, where the ends can line up while the middle wanders off the chord
+	SplineSample mid, quarter, threeQuarter;
+	float dMid = 0.5f * (d0 + d1);
+	Sample(dMid, mid);
+
+	bool bSplit = false;
+	if (depth < MAX_DEPTH) {
+		bSplit = glm::dot(s0.tangent, s1.tangent) < fCosMaxAngle || glm::dot(s0.up, s1.up) < fCosMaxAngle;
+		if (!bSplit) {
+			Sample(0.5f * (d0 + dMid), quarter);
+			Sample(0.5f * (dMid + d1), threeQuarter);
+
+			glm::vec3 chord = s1.position - s0.position;
+			float fChordLength = glm::length(chord);
+			glm::vec3 direction = fChordLength > 0.0f ? chord / fChordLength : s0.tangent;
+
+			const glm::vec3 *interior[3] = { &quarter.position, &mid.position, &threeQuarter.position };
+			for (int k = 0; k < 3 && !bSplit; k++) {
+				glm::vec3 v = *interior[k] - s0.position;
+				bSplit = glm::length(v - glm::dot(v, direction) * direction) > fMaxChordError;
+			}
+		}
+	}
+	if (!bSplit)
+		return;
+
+	SubdivideInterval(d0, s0, dMid, mid, fCosMaxAngle, fMaxChordError, depth + 1, points, distances, upVectors);
+	points.push_back(mid.position);
+	distances.push_back(dMid);
+	if (m_controlUpVectors.size() > 0)
+		upVectors.push_back(mid.up);
+	SubdivideInterval(dMid, mid, d1, s1, fCosMaxAngle, fMaxChordError, depth + 1, points, distances, upVectors);
+}
+
+// Switch the track over to editing.  The centreline is resampled with samplesPerSegment points on each segment, and the track mesh 
+// becomes one block per segment (see CTrackMesh::BuildBlocks), so that an edit to a control point only touches the few segments 
+// whose four control points include it.  Call after CreateTrack; the track buffers are replaced on the next RenderTrack.
+void CCatmullRom::BeginEditing(int samplesPerSegment)
+{
+	int M = (int)m_controlPoints.size();
+	if (M < 4 || samplesPerSegment < 1)
+		return;
+
+	m_editing = true;
+	m_samplesPerSegment = samplesPerSegment;
+
+	m_segmentBlocks.resize(M);
+	m_blockSegments.resize(M);
+	for (int j = 0; j < M; j++)
+		m_segmentBlocks[j] = m_blockSegments[j] = j;
+
+	int numSamples = M * samplesPerSegment;
+	m_centrelinePoints.resize(numSamples);
+	m_centrelineDistances.resize(numSamples);
+	m_centrelineUpVectors.resize(m_controlUpVectors.empty() ? 0 : numSamples);
+	m_centrelineFrames.resize(numSamples);
+	for (int j = 0; j < M; j++)
+		ResampleSegment(j);
+	ComputeCentrelineFrames();
+	ComputeOffsetCurves();
+
+	// The mesh may have been using the track cache, which is no longer needed
+	m_trackMesh.BuildBlocks(M, 2 * M, samplesPerSegment);
+	m_trackCache.Close();
+	for (int j = 0; j < M; j++)
+		UpdateTrackBlock(j);
+
+	m_dirtyBlocks.clear();
+	m_trackBuffersStale = true;
+	m_curveBuffersStale = true;
+}
+
+bool CCatmullRom::IsEditing() const
+{
+	return m_editing;
+}
+
+int CCatmullRom::GetNumControlPoints() const
+{
+	return (int)m_controlPoints.size();
+}
+
+glm::vec3 CCatmullRom::GetControlPoint(int i) const
+{
+	return m_controlPoints[i];
+}
+
+int CCatmullRom::NearestControlPoint(const glm::vec3 &p) const
+{
+	int iNearest = 0;
+	float fNearest = glm::dot(m_controlPoints[0] - p, m_controlPoints[0] - p);
+	for (int i = 1; i < (int)m_controlPoints.size(); i++) {
+		float f = glm::dot(m_controlPoints[i] - p, m_controlPoints[i] - p);
+		if (f < fNearest) {
+			fNearest = f;
+			iNearest = i;
+		}
+	}
+	return iNearest;
+}
+
+// Move control point i (and set its upvector, if the track has them).  Segments i - 2 to i + 1 depend on it.
+bool CCatmullRom::MoveControlPoint(int i, const glm::vec3 &p, const glm::vec3 &up)
+{
+	int M = (int)m_controlPoints.size();
+	if (!m_editing || i < 0 || i >= M)
+		return false;
+
+	m_controlPoints[i] = p;
+	if (!m_controlUpVectors.empty())
+		m_controlUpVectors[i] = glm::normalize(up);
+
+	UpdateSegments(i - 2, 4);
+	return true;
+}
+
+// Insert a control point before control point i (at the end if i is the number of points).  The new segment i gets a new block 
+// at the end of the track mesh; segments i - 2 to i + 1 depend on the new point.
+bool CCatmullRom::InsertControlPoint(int i, const glm::vec3 &p, const glm::vec3 &up)
+{
+	int M = (int)m_controlPoints.size();
+	if (!m_editing || i < 0 || i > M)
+		return false;
+
+	int K = m_samplesPerSegment;
+	m_controlPoints.insert(m_controlPoints.begin() + i, p);
+	if (!m_controlUpVectors.empty())
+		m_controlUpVectors.insert(m_controlUpVectors.begin() + i, glm::normalize(up));
+
+	// Make room for the new segment in the per segment tables; the entries are filled in by UpdateSegments
+	m_segments.insert(m_segments.begin() + i, SplineSegment());
+	if (!m_upSegments.empty())
+		m_upSegments.insert(m_upSegments.begin() + i, SplineSegment());
+	m_arcLengthTable.insert(m_arcLengthTable.begin() + i * (ARC_LENGTH_TABLE_SIZE + 1), ARC_LENGTH_TABLE_SIZE + 1, 0.0f);
+	m_segmentBoundsMin.insert(m_segmentBoundsMin.begin() + i, glm::vec3(0.0f));
+	m_segmentBoundsMax.insert(m_segmentBoundsMax.begin() + i, glm::vec3(0.0f));
+	m_distances.insert(m_distances.begin() + i, 0.0f);
+
+	m_centrelinePoints.insert(m_centrelinePoints.begin() + i * K, K, glm::vec3(0.0f));
+	m_centrelineDistances.insert(m_centrelineDistances.begin() + i * K, K, 0.0f);
+	if (!m_centrelineUpVectors.empty())
+		m_centrelineUpVectors.insert(m_centrelineUpVectors.begin() + i * K, K, glm::vec3(0.0f));
+	m_centrelineFrames.insert(m_centrelineFrames.begin() + i * K, K, TrackFrame());
+	m_leftOffsetPoints.insert(m_leftOffsetPoints.begin() + i * K, K, glm::vec3(0.0f));
+	m_rightOffsetPoints.insert(m_rightOffsetPoints.begin() + i * K, K, glm::vec3(0.0f));
+
+	int block = (int)m_blockSegments.size();
+	for (int b = 0; b < block; b++) {
+		if (m_blockSegments[b] >= i)
+			m_blockSegments[b]++;
+	}
+	m_blockSegments.push_back(i);
+	m_segmentBlocks.insert(m_segmentBlocks.begin() + i, block);
+	if (m_trackMesh.SetNumBlocks(M + 1))
+		m_trackBuffersStale = true;
 
-	// Call UniformlySampleControlPoints with the number of samples required
-	UniformlySampleControlPoints(500);
+	UpdateSegments(i - 2, 4);
+	return true;
+}
+
+// Remove control point i, keeping at least four.  Its segment's block is filled by moving the last block into it, so the blocks 
+// in use stay contiguous; segments i - 2 to i (after renumbering) depend on the points either side of the gap.
+bool CCatmullRom::RemoveControlPoint(int i)
+{
+	int M = (int)m_controlPoints.size();
+	if (!m_editing || i < 0 || i >= M || M <= 4)
+		return false;
+
+	int K = m_samplesPerSegment;
+	m_controlPoints.erase(m_controlPoints.begin() + i);
+	if (!m_controlUpVectors.empty())
+		m_controlUpVectors.erase(m_controlUpVectors.begin() + i);
+
+	int block = m_segmentBlocks[i];
+	int lastBlock = M - 1;
+	if (block != lastBlock) {
+		int segment = m_blockSegments[lastBlock];
+		m_trackMesh.CopyBlock(lastBlock, block);
+		m_segmentBlocks[segment] = block;
+		m_blockSegments[block] = segment;
+		m_dirtyBlocks.push_back(block);
+	}
+	m_blockSegments.pop_back();
+	m_segmentBlocks.erase(m_segmentBlocks.begin() + i);
+	for (int b = 0; b < M - 1; b++) {
+		if (m_blockSegments[b] > i)
+			m_blockSegments[b]--;
+	}
+	m_trackMesh.SetNumBlocks(M - 1);
+
+	m_segments.erase(m_segments.begin() + i);
+	if (!m_upSegments.empty())
+		m_upSegments.erase(m_upSegments.begin() + i);
+	m_arcLengthTable.erase(m_arcLengthTable.begin() + i * (ARC_LENGTH_TABLE_SIZE + 1), m_arcLengthTable.begin() + (i + 1) * (ARC_LENGTH_TABLE_SIZE + 1));
+	m_segmentBoundsMin.erase(m_segmentBoundsMin.begin() + i);
+	m_segmentBoundsMax.erase(m_segmentBoundsMax.begin() + i);
+	m_distances.erase(m_distances.begin() + i);
+
+	m_centrelinePoints.erase(m_centrelinePoints.begin() + i * K, m_centrelinePoints.begin() + (i + 1) * K);
+	m_centrelineDistances.erase(m_centrelineDistances.begin() + i * K, m_centrelineDistances.begin() + (i + 1) * K);
+	if (!m_centrelineUpVectors.empty())
+		m_centrelineUpVectors.erase(m_centrelineUpVectors.begin() + i * K, m_centrelineUpVectors.begin() + (i + 1) * K);
+	m_centrelineFrames.erase(m_centrelineFrames.begin() + i * K, m_centrelineFrames.begin() + (i + 1) * K);
+	m_leftOffsetPoints.erase(m_leftOffsetPoints.begin() + i * K, m_leftOffsetPoints.begin() + (i + 1) * K);
+	m_rightOffsetPoints.erase(m_rightOffsetPoints.begin() + i * K, m_rightOffsetPoints.begin() + (i + 1) * K);
+
+	UpdateSegments(i - 2, 3);
+	return true;
+}
+
+// Bring everything up to date after the control points of count segments from first on (wrapping around the loop) have changed
+void CCatmullRom::UpdateSegments(int first, int count)
+{
+	int M = (int)m_controlPoints.size();
+	int K = m_samplesPerSegment;
+	if (count > M)
+		count = M;
+	first = (first % M + M) % M;
+
+	// Coefficients and arc length tables of the changed segments only
+	for (int k = 0; k < count; k++) {
+		int j = (first + k) % M;
+		ComputeSegmentCoefficients(j);
+		ComputeArcLengthTable(j);
+		ComputeSegmentBounds(j);
+	}
+	m_segmentGrid.Build(m_segmentBoundsMin, m_segmentBoundsMax);
+
+	// The distances to the start of each segment are a running sum of the segment lengths (the last entry of each table row), and 
+	// the centreline distances follow them.  Both are linear and cheap next to resampling, so they are simply redone.
+	for (int j = 0; j < M; j++)
+		m_distances[j + 1] = m_distances[j] + m_arcLengthTable[j * (ARC_LENGTH_TABLE_SIZE + 1) + ARC_LENGTH_TABLE_SIZE];
+	for (int j = 0; j < M; j++) {
+		float fSegmentLength = m_distances[j + 1] - m_distances[j];
+		for (int k = 0; k < K; k++)
+			m_centrelineDistances[j * K + k] = m_distances[j] + fSegmentLength * k / K;
+	}
+
+	for (int k = 0; k < count; k++)
+		ResampleSegment((first + k) % M);
+	UpdateCentrelineFrames(first * K, count * K);
+
+	int numSamples = M * K;
+	for (int k = 0; k < count * K; k++) {
+		int i = (first * K + k) % numSamples;
+		glm::vec3 normal = m_centrelineFrames[i].N;
+		m_leftOffsetPoints[i] = m_centrelinePoints[i] - ((m_pathWidth / 2) * normal);
+		m_rightOffsetPoints[i] = m_centrelinePoints[i] + ((m_pathWidth / 2) * normal);
+	}
+
+	// The block before the changed ones ends on the first changed sample
+	for (int k = -1; k < count; k++)
+		UpdateTrackBlock((first + k + M) % M);
+	m_curveBuffersStale = true;
+}
+
+// Sample segment j at m_samplesPerSegment points equally spaced in arc length, from its start up to (but not including) its end
+void CCatmullRom::ResampleSegment(int j)
+{
+	int K = m_samplesPerSegment;
+	float fSegmentLength = m_distances[j + 1] - m_distances[j];
+
+	SplineSample sample;
+	for (int k = 0; k < K; k++) {
+		int i = j * K + k;
+		m_centrelineDistances[i] = m_distances[j] + fSegmentLength * k / K;
+		SampleSegment(j, m_centrelineDistances[i], sample);
+		m_centrelinePoints[i] = sample.position;
+		m_centrelineFrames[i].T = sample.tangent;
+		if (!m_centrelineUpVectors.empty())
+			m_centrelineUpVectors[i] = sample.up;
+	}
+}
+
+// Write the vertices of segment j's block of the track mesh.  The texture repeats a whole number of times along each segment, so 
+// it lines up across blocks without depending on the distance to the segment.
+void CCatmullRom::UpdateTrackBlock(int j)
+{
+	int M = (int)m_controlPoints.size();
+	int K = m_samplesPerSegment;
+	int block = m_segmentBlocks[j];
+
+	float fSegmentLength = m_distances[j + 1] - m_distances[j];
+	float fRepeats = floorf(fSegmentLength / m_pathWidth + 0.5f);
+	if (fRepeats < 1.0f)
+		fRepeats = 1.0f;
+
+	TrackVertex *pVertices = m_trackMesh.GetBlockVertices(block);
+	for (int k = 0; k <= K; k++) {
+		int i = k < K ? j * K + k : ((j + 1) % M) * K;
+		float u = fRepeats * k / K;
+
+		pVertices[2 * k].position = m_leftOffsetPoints[i];
+		pVertices[2 * k].texCoord = glm::vec2(u, 0.0f);
+		pVertices[2 * k].normal = m_centrelineFrames[i].B;
+		pVertices[2 * k + 1].position = m_rightOffsetPoints[i];
+		pVertices[2 * k + 1].texCoord = glm::vec2(u, 1.0f);
+		pVertices[2 * k + 1].normal = m_centrelineFrames[i].B;
+	}
+
+	m_trackMesh.UpdateBlockBounds(block, m_distances[j], m_distances[j + 1]);
+	m_dirtyBlocks.push_back(block);
+}
+
+// Send track edits to the GPU: everything after BeginEditing or when the mesh has grown, otherwise only the blocks that changed
+void CCatmullRom::UploadTrackEdits()
+{
+	if (m_trackBuffersStale) {
+		if (m_vaoTrack == 0)
+			glGenVertexArrays(1, &m_vaoTrack);
+		if (m_vboTrackVertices == 0) {
+			glGenBuffers(1, &m_vboTrackVertices);
+			glGenBuffers(1, &m_vboTrackIndices);
+		}
+
+		glBindVertexArray(m_vaoTrack);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vboTrackVertices);
+		glBufferData(GL_ARRAY_BUFFER, m_trackMesh.GetVertexCount() * sizeof(TrackVertex), m_trackMesh.GetVertexData(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vboTrackIndices);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_trackMesh.GetIndexCount() * m_trackMesh.GetIndexSize(), m_trackMesh.GetIndexData(), GL_STATIC_DRAW);
+		SetTrackVertexAttributes();
+
+		m_indexType = m_trackMesh.GetIndexType();
+		m_trackBuffersStale = false;
+	}
+	else if (!m_dirtyBlocks.empty()) {
+		std::sort(m_dirtyBlocks.begin(), m_dirtyBlocks.end());
+		m_dirtyBlocks.erase(std::unique(m_dirtyBlocks.begin(), m_dirtyBlocks.end()), m_dirtyBlocks.end());
+
+		GLsizeiptr blockSize = m_trackMesh.GetBlockVertexCount() * sizeof(TrackVertex);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vboTrackVertices);
+		for (unsigned int i = 0; i < m_dirtyBlocks.size(); i++)
+			glBufferSubData(GL_ARRAY_BUFFER, m_dirtyBlocks[i] * blockSize, blockSize, m_trackMesh.GetBlockVertices(m_dirtyBlocks[i]));
+	}
+
+	m_dirtyBlocks.clear();
+	m_indexCount = m_trackMesh.GetFullDetailIndexCount();
+}
+
+// Replace the points in the VBO behind vao (created by CreateCentreline or CreateOffsetCurves) with points, in the same layout
+static void UploadCurvePoints(GLuint vao, const vector<glm::vec3> &points, const glm::vec2 &texCoord)
+{
+	glm::vec3 normal(0.0f, 1.0f, 0.0f);
+	vector<BYTE> data;
+	data.reserve(points.size() * (2 * sizeof(glm::vec3) + sizeof(glm::vec2)));
+	for (size_t i = 0; i < points.size(); i++) {
+		data.insert(data.end(), (const BYTE*)&points[i], (const BYTE*)&points[i] + sizeof(glm::vec3));
+		data.insert(data.end(), (const BYTE*)&texCoord, (const BYTE*)&texCoord + sizeof(glm::vec2));
+		data.insert(data.end(), (const BYTE*)&normal, (const BYTE*)&normal + sizeof(glm::vec3));
+	}
+
+	GLint vbo = 0;
+	glBindVertexArray(vao);
+	glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, (GLuint)vbo);
+	glBufferData(GL_ARRAY_BUFFER, data.size(), data.empty() ? NULL : &data[0], GL_DYNAMIC_DRAW);
+}
+
+// Send the edited centreline and offset curves to the GPU.  Edits change the number of points as well as where they are, so the 
+// curves are uploaded whole rather than by block.
+void CCatmullRom::UploadCurveEdits()
+{
+	if (!m_curveBuffersStale)
+		return;
+
+	if (m_vaoCentreline != 0)
+		UploadCurvePoints(m_vaoCentreline, m_centrelinePoints, glm::vec2(10.0f, 10.0f));
+	if (m_vaoLeftOffsetCurve != 0)
+		UploadCurvePoints(m_vaoLeftOffsetCurve, m_leftOffsetPoints, glm::vec2(0.0f, 0.0f));
+	if (m_vaoRightOffsetCurve != 0)
+		UploadCurvePoints(m_vaoRightOffsetCurve, m_rightOffsetPoints, glm::vec2(0.0f, 0.0f));
+	m_curveBuffersStale = false;
+}
+
+void CCatmullRom::CreateCentreline()
+{
+	// Fall back on the built in control points if no track has been loaded, and sample the centreline, uniformly or adaptively 
+	// depending on the tessellation setting
+	if (m_centrelinePoints.empty()) {
+		SetControlPoints();
+		Tessellate();
+	}
 
 	// Create a VAO called m_vaoCentreline and a VBO to get the points onto the graphics card
 
@@ -166,11 +1596,11 @@ void CCatmullRom::CreateCentreline()
 	glm::vec2 texCoord(10.0f, 10.0f);
 	glm::vec3 normal(0.0f, 1.0f, 0.0f);
 
-	int M = (int)m_controlPoints.size();
+	int M = (int)m_centrelinePoints.size();
 
 	for (int i = 0; i < M; i++) 
 	{
-		glm::vec3 v =  m_controlPoints[i];
+		glm::vec3 v =  m_centrelinePoints[i];
 		vbo.AddData(&v, sizeof(glm::vec3));
 		vbo.AddData(&texCoord, sizeof(glm::vec2));
 		vbo.AddData(&normal, sizeof(glm::vec3));
@@ -195,26 +1625,32 @@ void CCatmullRom::CreateCentreline()
 	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(glm::vec3)+ sizeof(glm::vec2)));
 }
 
+// Offset the centreline half the path width to either side, along N of the rotation minimising frames
+void CCatmullRom::ComputeOffsetCurves()
+{
+	int M = (int)m_centrelinePoints.size();
+
+	m_leftOffsetPoints.resize(M);
+	m_rightOffsetPoints.resize(M);
+	ParallelFor(0, M, 4096, [&](int first, int last) {
+		for (int i = first; i < last; i++)
+		{
+			glm::vec3 normal = m_centrelineFrames[i].N;
+
+			m_leftOffsetPoints[i] = m_centrelinePoints[i] - ((m_pathWidth / 2) * normal);
+			m_rightOffsetPoints[i] = m_centrelinePoints[i] + ((m_pathWidth / 2) * normal);
+		}
+	});
+}
+
 void CCatmullRom::CreateOffsetCurves()
 {
 	// Compute the offset curves, one left, and one right.  Store the points in m_leftOffsetPoints and m_rightOffsetPoints respectively
 
 	// Generate two VAOs called m_vaoLeftOffsetCurve and m_vaoRightOffsetCurve, each with a VBO, and get the offset curve points on the graphics card
 	// Note it is possible to only use one VAO / VBO with all the points instead.
-	int M = (int)m_centrelinePoints.size();
-
-	for (int i = 0; i < M-1; i++)
-	{
-		//a normalised tangent vector T that points from p to pNext
-		glm::vec3 tangent = glm::normalize(m_centrelinePoints[i + 1] - m_centrelinePoints[i]);
-		glm::vec3 y = glm::vec3(0,1,0);
-		glm::vec3 normal = glm::cross(tangent, y);
-
-		m_leftOffsetPoints.push_back(m_centrelinePoints[i] - ((m_pathWidth / 2) * normal));
-		m_rightOffsetPoints.push_back(m_centrelinePoints[i] + ((m_pathWidth / 2) * normal));
-
-		std::cout << glm::to_string(m_leftOffsetPoints[i]) << std::endl;
-	}
+	if (m_leftOffsetPoints.size() != m_centrelinePoints.size())
+		ComputeOffsetCurves();
 
 	// Use VAO to store state associated with vertices
 	glGenVertexArrays(1, &m_vaoLeftOffsetCurve);
@@ -297,6 +1733,17 @@ void CCatmullRom::CreateOffsetCurves()
 	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride_r, (void*)(sizeof(glm::vec3) + sizeof(glm::vec2)));
 }
 
+// Build the indexed track surface on the CPU, with the texture repeating every path width along the track so it isn't stretched
+void CCatmullRom::BuildTrackMesh()
+{
+	m_trackMesh.Build(m_leftOffsetPoints, m_rightOffsetPoints, m_centrelineDistances, m_centrelineFrames, GetTotalLength(), m_pathWidth, m_chunkLength);
+}
+
+const CTrackMesh &CCatmullRom::GetTrackMesh() const
+{
+	return m_trackMesh;
+}
+
 void CCatmullRom::CreateTrack()
 {
 	// Load the texture
@@ -308,76 +1755,34 @@ void CCatmullRom::CreateTrack()
 	m_texture.SetSamplerObjectParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
 	m_texture.SetSamplerObjectParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	// Generate a VAO called m_vaoTrack and a VBO to get the offset curve points and indices on the graphics card
+	// The mesh may already have come from the track cache
+	if (m_trackMesh.GetVertexCount() == 0)
+		BuildTrackMesh();
+	if (m_trackMesh.GetVertexCount() == 0)
+		return;
 
-	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 	// Use VAO to store state associated with vertices
 	glGenVertexArrays(1, &m_vaoTrack);
 	glBindVertexArray(m_vaoTrack);
 
-	// Create a VBO
-	CVertexBufferObject vaoTrack;
-	vaoTrack.Create();
-	vaoTrack.Bind();
-
-	glm::vec2 texCoord00(0.0f, 0.0f);
-	glm::vec2 texCoord01(0.0f, 1);
-	glm::vec2 texCoord10(0.1f, 0);
-	glm::vec2 texCoord11(0.1f, 1);
-
-	m_vertexCount = (int)m_rightOffsetPoints.size() - m_pathVertexOffset;
+	// Create a VBO and upload the interleaved vertices and indices as they are
+	CVertexBufferObjectIndexed vboTrack;
+	vboTrack.Create();
+	vboTrack.Bind();
+	vboTrack.AddVertexData((void*)m_trackMesh.GetVertexData(), m_trackMesh.GetVertexCount() * sizeof(TrackVertex));
+	vboTrack.AddIndexData((void*)m_trackMesh.GetIndexData(), m_trackMesh.GetIndexCount() * m_trackMesh.GetIndexSize());
+	vboTrack.UploadDataToGPU(GL_STATIC_DRAW);
 
-	for (int i = 0; i < m_vertexCount; i+= m_pathVertexOffset)
-	{
-		m_pathPoints.push_back(m_leftOffsetPoints[i]);//490
-		m_pathUV.push_back(texCoord00);
-
-		m_pathPoints.push_back(m_rightOffsetPoints[i]);//490
-		m_pathUV.push_back(texCoord01);
-
-		m_pathPoints.push_back(m_leftOffsetPoints[i + m_pathVertexOffset]);//500
-		m_pathUV.push_back(texCoord10);
-
-		m_pathPoints.push_back(m_leftOffsetPoints[i + m_pathVertexOffset]);//500
-		m_pathUV.push_back(texCoord10);
-
-		m_pathPoints.push_back(m_rightOffsetPoints[i]);//490
-		m_pathUV.push_back(texCoord01);
-
-		m_pathPoints.push_back(m_rightOffsetPoints[i + m_pathVertexOffset]);//500
-		m_pathUV.push_back(texCoord11);
-	}
+	m_indexCount = m_trackMesh.GetFullDetailIndexCount();
+	m_indexType = m_trackMesh.GetIndexType();
 
-	//For connecting loop
-	/*m_pathPoints.push_back(m_leftOffsetPoints[m_vertexCount]);
-	m_pathPoints.push_back(m_rightOffsetPoints[m_vertexCount]);
-	m_pathPoints.push_back(m_leftOffsetPoints[0]);
-
-	m_pathPoints.push_back(m_leftOffsetPoints[0]);
-	m_pathPoints.push_back(m_rightOffsetPoints[m_vertexCount]);
-	m_pathPoints.push_back(m_rightOffsetPoints[0]);
-
-	m_pathPoints.push_back(m_leftOffsetPoints[0]);
-	m_pathPoints.push_back(m_rightOffsetPoints[0]);
-	m_pathPoints.push_back(m_leftOffsetPoints[m_pathVertexOffset]);*/
-
-	m_vertexCount = (int)m_pathPoints.size();
-
-	glm::vec3 normal(0.0f, 1.0f, 0.0f);
-
-	// Put the vertex attributes in the VBO
-	for (unsigned int i = 0; i < m_vertexCount; i++)
-	{
-		vaoTrack.AddData(&m_pathPoints[i], sizeof(glm::vec3));
-		vaoTrack.AddData(&m_pathUV[i], sizeof(glm::vec2));
-		vaoTrack.AddData(&normal, sizeof(glm::vec3));
-	}
-
-	// Upload the VBO to the GPU
-	vaoTrack.UploadDataToGPU(GL_STATIC_DRAW);
+	SetTrackVertexAttributes();
+}
 
-	// Set the vertex attribute locations
-	GLsizei istride = 2 * sizeof(glm::vec3) + sizeof(glm::vec2);
+// Point the vertex attributes of the bound VAO at the interleaved TrackVertex data in the bound VBO
+void CCatmullRom::SetTrackVertexAttributes()
+{
+	GLsizei istride = sizeof(TrackVertex);
 
 	// Vertex positions
 	glEnableVertexAttribArray(0);
@@ -392,16 +1797,22 @@ void CCatmullRom::CreateTrack()
 
 void CCatmullRom::RenderCentreline()
 {
+	if (m_editing)
+		UploadCurveEdits();
+
 	// Bind the VAO m_vaoCentreline and render it
 	glBindVertexArray(m_vaoCentreline);
 
-	int M = (int)m_controlPoints.size();
+	int M = (int)m_centrelinePoints.size();
 	glLineWidth(5);
 	glDrawArrays(GL_POINTS, 0, M);
 }
 
 void CCatmullRom::RenderOffsetCurves()
 {
+	if (m_editing)
+		UploadCurveEdits();
+
 	// Bind the VAO m_vaoLeftOffsetCurve and render it
 	glBindVertexArray(m_vaoLeftOffsetCurve);
 
@@ -419,13 +1830,60 @@ void CCatmullRom::RenderOffsetCurves()
 
 void CCatmullRom::RenderTrack()
 {
+	if (m_editing)
+		UploadTrackEdits();
+
 	// Bind the VAO m_vaoTrack and render it
 	glBindVertexArray(m_vaoTrack);
 	m_texture.Bind();
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_vertexCount);
+	glDrawElements(GL_TRIANGLES, m_indexCount, m_indexType, 0);
+}
+
+// Render only the chunks of the track inside the view frustum, with distant ones at lower detail
+void CCatmullRom::RenderTrack(const glm::mat4 &viewProjection, const glm::vec3 &eye)
+{
+	if (m_editing)
+		UploadTrackEdits();
+
+	GetVisibleChunks(viewProjection, eye, m_visibleChunks);
+
+	glBindVertexArray(m_vaoTrack);
+	m_texture.Bind();
+
+	const vector<TrackChunk> &chunks = m_trackMesh.GetChunks();
+	unsigned int indexSize = m_trackMesh.GetIndexSize();
+	for (unsigned int i = 0; i < m_visibleChunks.size(); i++) {
+		const TrackChunk &chunk = chunks[m_visibleChunks[i].chunk];
+		int lod = m_visibleChunks[i].lod;
+		glDrawElements(GL_TRIANGLES, chunk.indexCount[lod], m_indexType, (void*)(size_t)(chunk.firstIndex[lod] * indexSize));
+	}
+}
+
+// Find the chunks of the track to draw for a projection * view matrix and eye position, such as those of a CCamera
+void CCatmullRom::GetVisibleChunks(const glm::mat4 &viewProjection, const glm::vec3 &eye, vector<TrackChunkDraw> &visible) const
+{
+	m_trackMesh.FindVisibleChunks(CFrustum(viewProjection), eye, visible);
 }
 
 int CCatmullRom::CurrentLap(float d)
 {
 	return (int)(d / m_distances.back());
+}
+
+float CCatmullRom::GetTotalLength() const
+{
+	if (m_distances.empty())
+		return 0.0f;
+
+	return m_distances.back();
+}
+
+int CCatmullRom::GetNumSegments() const
+{
+	return m_distances.empty() ? 0 : (int)m_distances.size() - 1;
+}
+
+float CCatmullRom::GetSegmentStart(int j) const
+{
+	return m_distances[j];
 }
\ No newline at end of file
@@ -1,41 +1,169 @@
 #pragma once
 #include "Common.h"
-#include "vertexBufferObject.h"
-#include "vertexBufferObjectIndexed.h"
+#include "VertexBufferObject.h"
+#include "VertexBufferObjectIndexed.h"
 #include "Texture.h"
+#include "TrackMesh.h"
+#include "MappedFile.h"
+#include "SegmentGrid.h"
+#include "SplineParameterization.h"
 #include "./include/glm/gtx/string_cast.hpp"
 
+// The centreline and its derivatives at one distance along it, from a single segment lookup
+struct SplineSample
+{
+	glm::vec3 position;
+	glm::vec3 tangent;		// Unit tangent, in the direction of travel
+	glm::vec3 normal;		// Unit principal normal, towards the centre of curvature (zero on a straight)
+	glm::vec3 up;			// Interpolated control upvector, or (0, 1, 0) if none were given
+	float curvature;		// 1 / radius of curvature
+};
+
+// Orthonormal frame along the track: T in the direction of travel, N to the side (the right offset curve is at +N) and B = N x T up
+struct TrackFrame
+{
+	glm::vec3 T, N, B;
+};
+
+// Where a point in space is relative to the track, from CCatmullRom::ProjectToTrack
+struct TrackProjection
+{
+	float distance;			// Distance along the centreline (within one lap) of the closest point
+	float lateral;			// Offset to the side of the centreline, along the frame's N (positive towards the right offset curve)
+	float height;			// Offset above the centreline, along the frame's B
+	int segment;			// Segment containing the closest point
+	glm::vec3 position;		// The closest point on the centreline
+};
+
+// Structure-of-arrays destination for CCatmullRom::SampleBatch.  Each non-NULL pointer must have room for n floats; 
+// leave a group NULL to skip computing it.
+struct SplineBatchOutput
+{
+	float *px, *py, *pz;	// Positions
+	float *tx, *ty, *tz;	// Unit tangents
+	float *ux, *uy, *uz;	// Unit upvectors, (0, 1, 0) if no control upvectors were given
+
+	SplineBatchOutput() : px(NULL), py(NULL), pz(NULL), tx(NULL), ty(NULL), tz(NULL), ux(NULL), uy(NULL), uz(NULL) {}
+};
+
 class CCatmullRom
 {
 public:
 	vector<glm::vec3> m_centrelinePoints;	// Centreline points
-
-	vector<glm::vec3> m_pathPoints;	// Centreline points
-	vector<glm::vec2> m_pathUV;	// Centreline points
+	vector<float> m_centrelineDistances;	// Distance along the curve of each centreline point
+	vector<TrackFrame> m_centrelineFrames;	// Rotation minimising frame at each centreline point
 
 	CCatmullRom();
 	~CCatmullRom();
 
+	void SetUniformTessellation(int numSamples);		// Equally spaced centreline points (500 by default)
+	void SetAdaptiveTessellation(float fMaxAngle, float fMaxChordError, float fMaxSpacing);	// Fewer points on straights, more on bends; fMaxAngle in degrees
+	void Tessellate();					// Sample the centreline from the control points; called by CreateCentreline
+
 	void CreateCentreline();
 	void RenderCentreline();
 
+	void ComputeOffsetCurves();			// CPU part of CreateOffsetCurves
+	void BuildTrackMesh();				// CPU part of CreateTrack
+	const CTrackMesh &GetTrackMesh() const;
+
 	void CreateOffsetCurves();
 	void RenderOffsetCurves();
 
 	void CreateTrack();
-	void RenderTrack();
+	void RenderTrack();			// Whole track at full detail
+	void RenderTrack(const glm::mat4 &viewProjection, const glm::vec3 &eye);	// Visible chunks only, with level of detail by distance from eye
+	void GetVisibleChunks(const glm::mat4 &viewProjection, const glm::vec3 &eye, vector<TrackChunkDraw> &visible) const;
 
 	int CurrentLap(float d); // Return the currvent lap (starting from 0) based on distance along the control curve.
 
-	bool Sample(float d, glm::vec3 &p, glm::vec3 &up = glm::vec3(0, 0, 0)); // Return a point on the centreline based on a certain distance along the control curve.
+	bool Sample(float d, glm::vec3 &p, glm::vec3 &up) const; // Return a point on the centreline based on a certain distance along the control curve.
+	bool Sample(float d, glm::vec3 &p) const; // The same, without the up vector.
+	bool Sample(float d, SplineSample &sample) const; // Return the point, tangent, normal and curvature at a certain distance along the control curve.
+	bool SampleFrame(float d, TrackFrame &frame) const; // Return the track frame at a certain distance along the control curve, interpolated from m_centrelineFrames.
+
+	// Choose how the curve passes through the control points (uniform Catmull-Rom by default), with a policy type from 
+	// SplineParameterization.h, or by type (SPLINE_KOCHANEK_BARTELS uses TightTCB).  Anything sampled from the old curve is discarded.
+	template <typename Parameterization> void SetParameterization();
+	void SetParameterization(SplineParameterizationType type);
+
+	void SetControlPoints(const vector<glm::vec3> &controlPoints, const vector<glm::vec3> &controlUpVectors); // Replace the control points (and optional upvectors) without touching the GPU
+	bool LoadTrack(const string &filename);	// Load a .track file and its baked cache, without touching the GPU; call before CreateCentreline
+	float GetTotalLength() const; // Return the length of one lap along the control curve
+
+	int GetNumSegments() const;			// Number of segments in one lap
+	float GetSegmentStart(int j) const;	// Distance along the curve at which segment j starts (GetSegmentStart(GetNumSegments()) is the lap length)
+	int FindSegment(float fLength) const; // Binary search m_distances for the segment containing fLength, a distance within one lap
+	bool SampleSegment(int j, float fLength, glm::vec3 &p, glm::vec3 &up) const; // Sample at fLength within one lap, given that it lies on segment j
+	bool SampleSegment(int j, float fLength, SplineSample &sample) const;
+
+	// Find the closest point on the centreline to p, using a grid over the segments' bounds and Newton's method on the cubics.  
+	// Returns false only if there is no track.
+	bool ProjectToTrack(const glm::vec3 &p, TrackProjection &projection) const;
+
+	// Interactive editing.  After BeginEditing, control points can be moved, inserted and removed, and only the segments around the 
+	// change are resampled and re-uploaded (on the next RenderTrack).  Upvectors are ignored if the track has none.
+	void BeginEditing(int samplesPerSegment);
+	bool IsEditing() const;
+	int GetNumControlPoints() const;
+	glm::vec3 GetControlPoint(int i) const;
+	int NearestControlPoint(const glm::vec3 &p) const;
+	bool MoveControlPoint(int i, const glm::vec3 &p, const glm::vec3 &up);
+	bool InsertControlPoint(int i, const glm::vec3 &p, const glm::vec3 &up);	// Insert before point i
+	bool RemoveControlPoint(int i);
+
+	// Sample n distances at once, writing positions, tangents and upvectors to out.  Distances are wrapped onto one lap (negative ones too).
+	// Uses SSE2 when available; positions match Sample to within 1e-5 relative to their magnitude, and upvectors to within 1e-5.
+	void SampleBatch(const float *d, size_t n, const SplineBatchOutput &out) const;
 
 private:
 	void SetControlPoints();
 	void ComputeLengthsAlongControlPoints();
 	void UniformlySampleControlPoints(int numSamples);
-	glm::vec3 Interpolate(glm::vec3 &p0, glm::vec3 &p1, glm::vec3 &p2, glm::vec3 &p3, float t);
-
-	vector<float> m_distances;
+	void AdaptivelySampleControlPoints(float fMaxAngle, float fMaxChordError, float fMaxSpacing);
+	void SubdivideInterval(float d0, const SplineSample &s0, float d1, const SplineSample &s1, float fCosMaxAngle, float fMaxChordError, int depth, 
+		vector<glm::vec3> &points, vector<float> &distances, vector<glm::vec3> &upVectors) const;
+	void ComputeCentrelineFrames();
+	void UpdateCentrelineFrames(int first, int count);
+	glm::vec3 TransportBinormal(int i, int iNext, const glm::vec3 &b) const;
+	void UpdateSegments(int first, int count);
+	void ResampleSegment(int j);
+	void UpdateTrackBlock(int j);
+	void UploadTrackEdits();
+	void UploadCurveEdits();
+	void SetTrackVertexAttributes();
+	void ComputeSegmentBounds(int j);
+	float ProjectToSegment(int j, const glm::vec3 &p, float &t) const;	// Closest parameter on segment j to p, returning the squared distance
+	unsigned long long ComputeCacheHash(unsigned long long sourceHash) const;
+	bool ReadTrackCache(const string &filename, unsigned long long hash);
+	void WriteTrackCache(const string &filename, unsigned long long hash) const;
+	void ComputeSegmentCoefficients();		// Rebuild m_segments and m_upSegments from the control points and upvectors
+	void ComputeSegmentCoefficients(int j);
+	float ComputeArcLengthTable(int j);		// Fill in row j of m_arcLengthTable, returning the segment length
+	static glm::vec3 Evaluate(const SplineSegment &segment, float t);
+	static glm::vec3 EvaluateDerivative(const SplineSegment &segment, float t);
+	static glm::vec3 EvaluateSecondDerivative(const SplineSegment &segment, float t);
+	float SegmentSpeed(int j, float t) const;						// |P'(t)| on segment j
+	float SegmentArcLength(int j, float t0, float t1) const;		// Arc length of segment j between t0 and t1 (Gauss-Legendre quadrature)
+	float WrapDistance(float d) const;								// A non-negative distance along the curve, wrapped onto one lap
+	float ParameterAtLength(int j, float fLength) const;			// Inverse of the arc length table: t at a length fLength into segment j
+	float BracketParameter(int j, float fLength, float &tLow, float &tHigh, float &fLengthAtLow) const;
+	float RefineParameter(int j, float t, float tLow, float tHigh, float fLengthError) const;
+
+	static const int ARC_LENGTH_TABLE_SIZE = 16;	// Number of intervals per segment in m_arcLengthTable
+
+	typedef void (*SegmentFunction)(const glm::vec3 *p, const glm::vec3 *pUp, SplineSegment &segment, SplineSegment &upSegment);
+	SegmentFunction m_computeSegments;	// ComputeSegments of the parameterization policy
+	float m_parameterization[4];		// Its TYPE, TENSION, CONTINUITY and BIAS, which identify the curve in the track cache
+
+	vector<SplineSegment> m_segments;	// Cubic coefficients of the centreline, one entry per control point (segment j runs from point j to j + 1)
+	vector<SplineSegment> m_upSegments;	// Cubic coefficients of the upvectors, empty if no control upvectors were given
+
+	vector<float> m_distances;			// Arc length at the start of each segment
+	vector<float> m_arcLengthTable;		// Per segment, arc length from the segment start at t = k / ARC_LENGTH_TABLE_SIZE, k = 0..ARC_LENGTH_TABLE_SIZE
+	vector<glm::vec3> m_segmentBoundsMin;	// Bounding box of each segment, for m_segmentGrid
+	vector<glm::vec3> m_segmentBoundsMax;
+	CSegmentGrid m_segmentGrid;			// Spatial index used by ProjectToTrack
 	CTexture m_texture;
 
 	GLuint m_vaoCentreline;
@@ -49,14 +177,49 @@ private:
 
 	vector<glm::vec3> m_leftOffsetPoints;	// Left offset curve points
 	vector<glm::vec3> m_rightOffsetPoints;	// Right offset curve points
-	
-	int m_pathVertexOffset = 1;
 
-	unsigned int m_vertexCount;				// Number of vertices in the track VBO
+	CTrackMesh m_trackMesh;					// CPU copy of the track surface
+	CMappedFile m_trackCache;				// Baked track the mesh may be using in place
+	unsigned int m_indexCount;				// Number of indices in the track VBO
+	GLenum m_indexType;						// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	float m_chunkLength;					// Length of the track chunks used for culling and level of detail
+	vector<TrackChunkDraw> m_visibleChunks;	// Scratch list for RenderTrack
+
+	// Editing state
+	bool m_editing;
+	int m_samplesPerSegment;
+	vector<int> m_segmentBlocks;			// Block of the track mesh holding each segment
+	vector<int> m_blockSegments;			// Segment held in each block
+	vector<int> m_dirtyBlocks;				// Blocks to upload on the next RenderTrack
+	bool m_trackBuffersStale;				// Whether the whole mesh needs uploading
+	bool m_curveBuffersStale;				// Whether the centreline and offset curve VBOs need uploading
+	GLuint m_vboTrackVertices;
+	GLuint m_vboTrackIndices;
 
 	// distance along the control path weve travelled
 	float m_currentDistance;
 
 	//path width
 	float m_pathWidth = 10;
+
+	// Tessellation setting
+	bool m_adaptiveTessellation;
+	int m_numUniformSamples;
+	float m_maxAngle;
+	float m_maxChordError;
+	float m_maxSpacing;
 };
+
+template <typename Parameterization> void CCatmullRom::SetParameterization()
+{
+	m_computeSegments = &Parameterization::ComputeSegments;
+	m_parameterization[0] = (float)Parameterization::TYPE;
+	m_parameterization[1] = Parameterization::TENSION;
+	m_parameterization[2] = Parameterization::CONTINUITY;
+	m_parameterization[3] = Parameterization::BIAS;
+
+	if (!m_controlPoints.empty()) {
+		vector<glm::vec3> controlPoints(m_controlPoints), controlUpVectors(m_controlUpVectors);
+		SetControlPoints(controlPoints, controlUpVectors);
+	}
+}
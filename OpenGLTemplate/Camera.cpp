@@ -1,5 +1,8 @@
-#include "camera.h"
-#include "gamewindow.h"
+#include "Camera.h"
+#include "Platform.h"
+#ifdef _WIN32
+#include "GameWindow.h"
+#endif
 
 // Constructor for camera -- initialise with some default values
 CCamera::CCamera()
@@ -13,7 +16,7 @@ CCamera::~CCamera()
 {}
  
 // Set the camera at a specific position, looking at the view point, with a given up vector
-void CCamera::Set(glm::vec3 &position, glm::vec3 &viewpoint, glm::vec3 &upVector)
+void CCamera::Set(const glm::vec3 &position, const glm::vec3 &viewpoint, const glm::vec3 &upVector)
 {
 	m_position = position;
 	m_view = viewpoint;
@@ -21,9 +24,10 @@ void CCamera::Set(glm::vec3 &position, glm::vec3 &viewpoint, glm::vec3 &upVector
 
 }
 
-// Respond to mouse movement
+// Respond to mouse movement.  Without a window (rendering offscreen) there's no pointer to follow.
 void CCamera::SetViewByMouse()
 {  
+#ifdef _WIN32
 	int middle_x = GameWindow::SCREEN_WIDTH >> 1;
 	int middle_y = GameWindow::SCREEN_HEIGHT >> 1;
 
@@ -59,6 +63,7 @@ void CCamera::SetViewByMouse()
 	}
 
 	RotateViewPoint(angle_y, glm::vec3(0, 1, 0));
+#endif
 }
 
 // Rotate the camera view point -- this effectively rotates the camera since it is looking at the view point
@@ -108,19 +113,19 @@ void CCamera::Update(double dt)
 // Update the camera to respond to key presses for translation
 void CCamera::TranslateByKeyboard(double dt)
 {
-	if (GetKeyState(VK_UP) & 0x80 || GetKeyState('W') & 0x80) {
+	if (PlatformKeyDown(VK_UP) || PlatformKeyDown('W')) {
 		Advance(1.0*dt);
 	}
 
-	if (GetKeyState(VK_DOWN) & 0x80 || GetKeyState('S') & 0x80) {
+	if (PlatformKeyDown(VK_DOWN) || PlatformKeyDown('S')) {
 		Advance(-1.0*dt);
 	}
 
-	if (GetKeyState(VK_LEFT) & 0x80 || GetKeyState('A') & 0x80) {
+	if (PlatformKeyDown(VK_LEFT) || PlatformKeyDown('A')) {
 		Strafe(-1.0*dt);
 	}
 
-	if (GetKeyState(VK_RIGHT) & 0x80 || GetKeyState('D') & 0x80) {
+	if (PlatformKeyDown(VK_RIGHT) || PlatformKeyDown('D')) {
 		Strafe(1.0*dt);
 	}
 }
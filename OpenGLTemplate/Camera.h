@@ -17,7 +17,7 @@ public:
 	glm::mat4 GetViewMatrix();						// Gets the camera view matrix - note this is not stored in the class but returned using glm::lookAt() in GetViewMatrix()
 
 	// Set the camera position, viewpoint, and up vector
-	void Set(glm::vec3 &position, glm::vec3 &viewpoint, glm::vec3 &upVector);
+	void Set(const glm::vec3 &position, const glm::vec3 &viewpoint, const glm::vec3 &upVector);
 	
 	// Rotate the camera viewpoint -- this effectively rotates the camera
 	void RotateViewPoint(float angle, glm::vec3 &viewPoint);
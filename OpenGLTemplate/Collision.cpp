@@ -0,0 +1,74 @@
+#include "Collision.h"
+
+// Moving sphere against a static one is a ray against a sphere of the two radii added together: solve |m + t d| = r for the 
+// first root, with m = p0 - centre and d = p1 - p0
+bool SweepSphereSphere(const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, const glm::vec3 &centre, float fCentreRadius, float &t)
+{
+	float r = fRadius + fCentreRadius;
+	glm::vec3 m = p0 - centre;
+	glm::vec3 d = p1 - p0;
+
+	float c = glm::dot(m, m) - r * r;
+	if (c <= 0.0f) {
+		t = 0.0f;
+		return true;
+	}
+
+	// Starting outside and not moving towards the centre, or missing it altogether
+	float b = glm::dot(m, d);
+	if (b >= 0.0f)
+		return false;
+	float a = glm::dot(d, d);
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f)
+		return false;
+
+	t = (-b - sqrtf(discriminant)) / a;
+	return t <= 1.0f;
+}
+
+// Distance from the point q, relative to the torus centre, to the surface of a torus with tube radius r
+static float TorusDistance(const glm::vec3 &q, const glm::vec3 &axis, float fMajorRadius, float r)
+{
+	float h = glm::dot(q, axis);
+	float radial = glm::length(q - h * axis) - fMajorRadius;
+	return sqrtf(radial * radial + h * h) - r;
+}
+
+// The torus grown by fRadius is tested against the segment by conservative advancement: the distance to its surface is never more 
+// than the distance to the nearest hit, so stepping that far along the segment can't pass through it.  This avoids solving the 
+// quartic of the exact ray-torus intersection, and the sweeps in a frame are short enough that few steps are needed.  A 
+// sweep that can't reach the torus's bounding sphere is rejected first.
+bool SweepSphereTorus(const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, const glm::vec3 &centre, const glm::vec3 &axis, 
+	float fMajorRadius, float fMinorRadius, float &t)
+{
+	const int maxSteps = 256;
+	const float fTolerance = 1e-4f;
+
+	float tBound;
+	if (!SweepSphereSphere(p0, p1, fRadius, centre, fMajorRadius + fMinorRadius, tBound))
+		return false;
+
+	float r = fRadius + fMinorRadius;
+	glm::vec3 d = p1 - p0;
+	float fLength = glm::length(d);
+
+	float tCurrent = tBound;
+	float fDistance = 0.0f;
+	for (int i = 0; i < maxSteps; i++) {
+		fDistance = TorusDistance(p0 + tCurrent * d - centre, axis, fMajorRadius, r);
+		if (fDistance <= fTolerance) {
+			t = tCurrent;
+			return true;
+		}
+		if (fLength <= 0.0f)
+			return false;
+		tCurrent += fDistance / fLength;
+		if (tCurrent > 1.0f)
+			return false;
+	}
+
+	// Still creeping along the surface after maxSteps: a graze, which counts as a hit if it is within 1% of the tube radius
+	t = tCurrent;
+	return fDistance <= 0.01f * r;
+}
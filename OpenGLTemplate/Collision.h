@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Common.h"
+
+// Continuous collision tests for a sphere of radius fRadius swept along the segment from p0 to p1, as the player moves between 
+// two frames.  Each returns true if the sphere touches the shape at some point on the segment, and sets t to the first such point 
+// as a fraction of the way from p0 to p1 (0 if it starts out touching).  Testing the sweep rather than the end positions means 
+// nothing is missed however far the sphere moves in a frame.
+
+// Against a sphere of radius fCentreRadius at centre
+bool SweepSphereSphere(const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, const glm::vec3 &centre, float fCentreRadius, float &t);
+
+// Against a solid torus at centre, with unit axis through its hole, fMajorRadius from the centre to the middle of the tube, and 
+// tube radius fMinorRadius
+bool SweepSphereTorus(const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, const glm::vec3 &centre, const glm::vec3 &axis, 
+	float fMajorRadius, float fMinorRadius, float &t);
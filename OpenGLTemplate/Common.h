@@ -1,5 +1,5 @@
 #include <ctime>
-#include <windows.h>
+#include "Platform.h"
 
 #include <cstring>
 #include <vector>
@@ -10,7 +10,11 @@
 #include "./include/glm/gtx/rotate_vector.hpp"
 
 #include "include/gl/glew.h"
+#ifdef _WIN32
 #include <gl/gl.h>
+#else
+#include <GL/gl.h>
+#endif
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -3,7 +3,7 @@
 #include "Cubemap.h"
 
 
-#include "include\freeimage\FreeImage.h"
+#include "include/freeimage/FreeImage.h"
 #pragma comment(lib, "lib/FreeImage.lib")
 
 
@@ -12,6 +12,7 @@ bool CCubemap::LoadTexture(string filename, BYTE **bmpBytes, int &iWidth, int &i
 	FREE_IMAGE_FORMAT fif = FIF_UNKNOWN;
 	FIBITMAP* dib(0);
 
+	filename = PlatformPath(filename);
 	fif = FreeImage_GetFileType(filename.c_str(), 0); // Check the file signature and deduce its format
 
 	if(fif == FIF_UNKNOWN) // If still unknown, try to guess the file format from the file extension
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Texture.h"
-#include "vertexBufferObject.h"
+#include "VertexBufferObject.h"
 #include "./include/glm/gtc/type_ptr.hpp"
 
 class CCubemap
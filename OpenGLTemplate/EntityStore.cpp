@@ -0,0 +1,151 @@
+#include "EntityStore.h"
+
+CEntityStore::CEntityStore()
+{
+	m_numKilled = 0;
+}
+
+CEntityStore::~CEntityStore()
+{}
+
+int CEntityStore::Create(EntityType type, const glm::vec3 &position, const glm::quat &orientation, float scale)
+{
+	int id;
+	if (!m_freeIds.empty()) {
+		id = m_freeIds.back();
+		m_freeIds.pop_back();
+	}
+	else {
+		id = (int)m_indices.size();
+		m_indices.push_back(-1);
+	}
+
+	m_indices[id] = (int)m_ids.size();
+	m_positions.push_back(position);
+	m_orientations.push_back(orientation);
+	m_scales.push_back(scale);
+	m_types.push_back((unsigned char)type);
+	m_alive.push_back(1);
+	m_ids.push_back(id);
+	return id;
+}
+
+void CEntityStore::Kill(int id)
+{
+	int index = GetIndex(id);
+	if (index >= 0 && m_alive[index]) {
+		m_alive[index] = 0;
+		m_numKilled++;
+	}
+}
+
+bool CEntityStore::IsAlive(int id) const
+{
+	int index = GetIndex(id);
+	return index >= 0 && m_alive[index] != 0;
+}
+
+void CEntityStore::Compact()
+{
+	// Walk backwards, so that the entity swapped into a slot has always been checked already
+	for (int index = (int)m_ids.size() - 1; index >= 0 && m_numKilled > 0; index--) {
+		if (!m_alive[index]) {
+			RemoveAt(index);
+			m_numKilled--;
+		}
+	}
+}
+
+void CEntityStore::RemoveAt(int index)
+{
+	int last = (int)m_ids.size() - 1;
+	int id = m_ids[index];
+	if (index != last) {
+		m_positions[index] = m_positions[last];
+		m_orientations[index] = m_orientations[last];
+		m_scales[index] = m_scales[last];
+		m_types[index] = m_types[last];
+		m_alive[index] = m_alive[last];
+		m_ids[index] = m_ids[last];
+		m_indices[m_ids[index]] = index;
+	}
+
+	m_positions.pop_back();
+	m_orientations.pop_back();
+	m_scales.pop_back();
+	m_types.pop_back();
+	m_alive.pop_back();
+	m_ids.pop_back();
+
+	m_indices[id] = -1;
+	m_freeIds.push_back(id);
+}
+
+void CEntityStore::Clear()
+{
+	m_positions.clear();
+	m_orientations.clear();
+	m_scales.clear();
+	m_types.clear();
+	m_alive.clear();
+	m_ids.clear();
+	m_indices.clear();
+	m_freeIds.clear();
+	m_numKilled = 0;
+}
+
+int CEntityStore::GetCount() const
+{
+	return (int)m_ids.size();
+}
+
+int CEntityStore::GetIndex(int id) const
+{
+	return id >= 0 && id < (int)m_indices.size() ? m_indices[id] : -1;
+}
+
+const glm::vec3 *CEntityStore::GetPositions() const
+{
+	return m_positions.empty() ? NULL : &m_positions[0];
+}
+
+const glm::quat *CEntityStore::GetOrientations() const
+{
+	return m_orientations.empty() ? NULL : &m_orientations[0];
+}
+
+const float *CEntityStore::GetScales() const
+{
+	return m_scales.empty() ? NULL : &m_scales[0];
+}
+
+const unsigned char *CEntityStore::GetTypes() const
+{
+	return m_types.empty() ? NULL : &m_types[0];
+}
+
+const unsigned char *CEntityStore::GetAlive() const
+{
+	return m_alive.empty() ? NULL : &m_alive[0];
+}
+
+const int *CEntityStore::GetIds() const
+{
+	return m_ids.empty() ? NULL : &m_ids[0];
+}
+
+glm::mat4 CEntityStore::GetTransform(int index) const
+{
+	glm::mat4 transform = glm::translate(glm::mat4(), m_positions[index]) * glm::mat4_cast(m_orientations[index]);
+	return glm::scale(transform, glm::vec3(m_scales[index]));
+}
+
+// Replaces transforms with the model matrix of every live entity of the given type, in dense order
+void CEntityStore::GetTransforms(EntityType type, vector<glm::mat4> &transforms) const
+{
+	transforms.clear();
+	for (size_t i = 0; i < m_positions.size(); i++) {
+		if (m_types[i] == type && m_alive[i])
+			transforms.push_back(GetTransform((int) i));
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Common.h"
+#include "./include/glm/gtc/quaternion.hpp"
+
+enum EntityType
+{
+	ENTITY_RING,			// Collectible; scores when the player passes through it
+	ENTITY_OBSTACLE
+};
+
+// Structure-of-arrays store for the game's many small objects (rings, obstacles).  Each property lives in its own dense array, 
+// so loops over one or two of them (positions for collision, transforms for rendering) touch only the memory they need.  Ids stay 
+// valid for the life of an entity, however the arrays are reordered: a sparse table maps each id to the entity's dense index.  
+// Kill only clears the alive flag, so it is safe in the middle of a loop over the arrays; Compact then fills each dead entity's 
+// slot with the last one (swap-remove), leaving the arrays dense again, and the freed ids are reused.
+class CEntityStore
+{
+public:
+	CEntityStore();
+	~CEntityStore();
+
+	int Create(EntityType type, const glm::vec3 &position, const glm::quat &orientation, float scale);	// Returns the new entity's id
+	void Kill(int id);
+	bool IsAlive(int id) const;
+	void Compact();					// Swap-remove every killed entity
+	void Clear();
+
+	int GetCount() const;			// Number of entities in the dense arrays, including any killed since the last Compact
+	int GetIndex(int id) const;		// Dense index of an entity, or -1 if the id is not in use
+
+	// The dense arrays, GetCount() long
+	const glm::vec3 *GetPositions() const;
+	const glm::quat *GetOrientations() const;
+	const float *GetScales() const;
+	const unsigned char *GetTypes() const;
+	const unsigned char *GetAlive() const;
+	const int *GetIds() const;
+
+	glm::mat4 GetTransform(int index) const;	// Model matrix of the entity at a dense index
+	void GetTransforms(EntityType type, vector<glm::mat4> &transforms) const;	// Model matrices of the live entities of one type, for instanced rendering
+
+private:
+	void RemoveAt(int index);
+
+	vector<glm::vec3> m_positions;
+	vector<glm::quat> m_orientations;
+	vector<float> m_scales;
+	vector<unsigned char> m_types;
+	vector<unsigned char> m_alive;
+	vector<int> m_ids;				// Id of the entity at each dense index
+
+	vector<int> m_indices;			// Dense index of each id, -1 if unused
+	vector<int> m_freeIds;
+	int m_numKilled;
+};
@@ -0,0 +1,105 @@
+#include "FramePacer.h"
+
+CFramePacer::CFramePacer()
+{
+	m_frequency = PlatformCounterFrequency();
+	m_interval = 1000.0 / 60.0;
+	m_spinMargin = 1.5;
+
+	// Sleep normally rounds up to the 15.6 ms system tick on Windows, far too coarse to pace frames with
+	m_raisedTimerResolution = PlatformBeginFineSleep();
+
+	Reset();
+}
+
+CFramePacer::~CFramePacer()
+{
+	if (m_raisedTimerResolution)
+		PlatformEndFineSleep();
+}
+
+void CFramePacer::SetTargetInterval(double intervalMs)
+{
+	m_interval = intervalMs;
+	Reset();
+}
+
+double CFramePacer::GetTargetInterval() const
+{
+	return m_interval;
+}
+
+void CFramePacer::Reset()
+{
+	m_origin = PlatformCounter();
+	m_deadline = m_interval;
+	m_lastError = 0.0;
+	m_averageError = 0.0;
+	m_maxError = 0.0;
+	m_numMissed = 0;
+}
+
+double CFramePacer::Now() const
+{
+	return (double) (PlatformCounter() - m_origin) * 1000.0 / m_frequency;
+}
+
+void CFramePacer::WaitForNextFrame()
+{
+	double now = Now();
+
+	// A frame that overran by a whole interval or more gives up the deadlines it missed, rather than rushing to catch up
+	if (now > m_deadline + m_interval) {
+		m_numMissed++;
+		m_deadline = now;
+	}
+
+	// Sleep in whole milliseconds while that can't overshoot, then yield until the deadline.  If Sleep wakes late, the margin 
+	// grows so that later frames stop sleeping earlier; it shrinks slowly back while Sleep keeps time.
+	while (m_deadline - now > m_spinMargin) {
+		unsigned int sleepMs = (unsigned int) (m_deadline - now - m_spinMargin);
+		double before = now;
+		PlatformSleep(sleepMs > 0 ? sleepMs : 1);
+		now = Now();
+		double oversleep = (now - before) - (sleepMs > 0 ? sleepMs : 1);
+		if (oversleep > m_spinMargin - 0.5)
+			m_spinMargin = oversleep + 0.5;
+		else
+			m_spinMargin = m_spinMargin * 0.99 + 0.01 * 1.5;
+		if (m_spinMargin > 0.5 * m_interval)
+			m_spinMargin = 0.5 * m_interval;
+	}
+	while (now < m_deadline) {
+		PlatformYield();
+		now = Now();
+	}
+
+	// Error, with an exponential average over roughly a second of frames
+	m_lastError = now - m_deadline;
+	double weight = m_interval / 1000.0;
+	m_averageError = m_averageError * (1.0 - weight) + m_lastError * weight;
+	if (m_lastError > m_maxError)
+		m_maxError = m_lastError;
+
+	m_deadline += m_interval;
+}
+
+double CFramePacer::GetLastError() const
+{
+	return m_lastError;
+}
+
+double CFramePacer::GetAverageError() const
+{
+	return m_averageError;
+}
+
+double CFramePacer::GetMaxError() const
+{
+	return m_maxError;
+}
+
+int CFramePacer::GetNumMissed() const
+{
+	return m_numMissed;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Platform.h"
+
+// Holds the game loop to a fixed frame interval without spinning.  Deadlines are kept on a fixed schedule (each one interval 
+// after the last, not after whenever the frame happened to finish), so timing errors don't accumulate.  The wait sleeps until 
+// just short of the deadline, with the system timer raised to 1 ms resolution where it needs to be, and yields the rest of the core for the last 
+// stretch, so the thread is asleep for nearly all of a frame's idle time.  The pacing error, how late each wait returned, is 
+// kept for display.
+class CFramePacer
+{
+public:
+	CFramePacer();
+	~CFramePacer();
+
+	void SetTargetInterval(double intervalMs);
+	double GetTargetInterval() const;
+
+	void Reset();				// Start the schedule from now, as after a pause
+	void WaitForNextFrame();	// Return at the next deadline, or at once if it has passed
+
+	double GetLastError() const;		// Milliseconds the last wait returned after its deadline
+	double GetAverageError() const;		// Averaged over the last second or so
+	double GetMaxError() const;			// Since Reset
+	int GetNumMissed() const;			// Deadlines that had already passed by a whole interval when the wait began
+
+private:
+	double Now() const;
+
+	long long m_frequency;
+	long long m_origin;
+	double m_interval;
+	double m_deadline;			// Milliseconds since m_origin
+	double m_spinMargin;		// How long before the deadline to stop sleeping and start yielding
+	bool m_raisedTimerResolution;
+
+	double m_lastError;
+	double m_averageError;
+	double m_maxError;
+	int m_numMissed;
+};
@@ -1,5 +1,4 @@
 #include "FreeTypeFont.h"
-#include <minmax.h>
 
 #pragma comment(lib, "lib/freetype2410.lib")
 
@@ -56,7 +55,7 @@ void CFreeTypeFont::CreateChar(int index)
 	m_bearingY[index] = m_ftFace->glyph->metrics.horiBearingY>>6;
 	m_charHeight[index] = m_ftFace->glyph->metrics.height>>6;
 
-	m_newLine = max(m_newLine, int(m_ftFace->glyph->metrics.height >> 6));
+	m_newLine = glm::max(m_newLine, int(m_ftFace->glyph->metrics.height >> 6));
 
 	// Rendering data, texture coordinates are always the same, so now we waste a little memory
 	glm::vec2 vQuad[] =
@@ -82,7 +81,7 @@ bool CFreeTypeFont::LoadFont(string file, int ipixelSize)
 {
 	BOOL bError = FT_Init_FreeType(&m_ftLib);
 	
-	bError = FT_New_Face(m_ftLib, file.c_str(), 0, &m_ftFace);
+	bError = FT_New_Face(m_ftLib, PlatformPath(file).c_str(), 0, &m_ftFace);
 	if(bError) {
 		char message[1024];
 		sprintf_s(message, "Cannot load font\n%s\n", file.c_str());
@@ -115,12 +114,7 @@ bool CFreeTypeFont::LoadFont(string file, int ipixelSize)
 // Loads a system font with given name (sName) and pixel size (iPXSize)
 bool CFreeTypeFont::LoadSystemFont(string name, int ipixelSize)
 {
-	char buf[512]; GetWindowsDirectory(buf, 512);
-	string sPath = buf;
-	sPath += "\\Fonts\\";
-	sPath += name;
-
-	return LoadFont(sPath, ipixelSize);
+	return LoadFont(PlatformFontPath(name), ipixelSize);
 }
 
 
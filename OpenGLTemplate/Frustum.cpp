@@ -0,0 +1,54 @@
+#include "Frustum.h"
+
+CFrustum::CFrustum()
+{}
+
+CFrustum::CFrustum(const glm::mat4 &viewProjection)
+{
+	Set(viewProjection);
+}
+
+CFrustum::~CFrustum()
+{}
+
+// Gribb & Hartmann: each plane is the last row of the matrix plus or minus one of the other rows.  glm matrices are column major, 
+// so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+void CFrustum::Set(const glm::mat4 &m)
+{
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	m_planes[0] = row3 + row0;
+	m_planes[1] = row3 - row0;
+	m_planes[2] = row3 + row1;
+	m_planes[3] = row3 - row1;
+	m_planes[4] = row3 + row2;
+	m_planes[5] = row3 - row2;
+
+	// Normalise, so that the plane equations give true distances for the sphere test
+	for (int i = 0; i < 6; i++)
+		m_planes[i] /= glm::length(glm::vec3(m_planes[i]));
+}
+
+bool CFrustum::ContainsSphere(const glm::vec3 &centre, float radius) const
+{
+	for (int i = 0; i < 6; i++) {
+		if (glm::dot(glm::vec3(m_planes[i]), centre) + m_planes[i].w < -radius)
+			return false;
+	}
+	return true;
+}
+
+// Test the corner of the box furthest along each plane normal; if even that is outside, the whole box is
+bool CFrustum::ContainsBox(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const
+{
+	for (int i = 0; i < 6; i++) {
+		glm::vec3 n(m_planes[i]);
+		glm::vec3 corner(n.x >= 0.0f ? boxMax.x : boxMin.x, n.y >= 0.0f ? boxMax.y : boxMin.y, n.z >= 0.0f ? boxMax.z : boxMin.z);
+		if (glm::dot(n, corner) + m_planes[i].w < 0.0f)
+			return false;
+	}
+	return true;
+}
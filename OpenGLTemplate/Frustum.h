@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Common.h"
+
+// The six clipping planes of a view frustum, taken from a combined projection * view (* model) matrix.  Used to cull geometry 
+// on the CPU before it is submitted.
+class CFrustum
+{
+public:
+	CFrustum();
+	CFrustum(const glm::mat4 &viewProjection);
+	~CFrustum();
+
+	void Set(const glm::mat4 &viewProjection);	// Extract the planes; they are in the space the matrix transforms from
+
+	bool ContainsSphere(const glm::vec3 &centre, float radius) const;			// False only if the sphere is entirely outside
+	bool ContainsBox(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const;	// False only if the axis aligned box is entirely outside
+
+private:
+	glm::vec4 m_planes[6];		// (n, d) with n.p + d >= 0 inside; left, right, bottom, top, near, far
+};
@@ -16,12 +16,14 @@ Source code drawn from a number of sources and examples, including contributions
  Dr Greg Slabaugh (gregory.slabaugh.1@city.ac.uk) 
 */
 
-#include "game.h"
+#include "Game.h"
 
 // Setup includes
 #include "HighResolutionTimer.h"
-#include "GameWindow.h"
+#include "OffscreenContext.h"
 #include <iostream>
+#include <iomanip>
+#include <algorithm>
 
 // Game includes
 #include "Camera.h"
@@ -34,6 +36,12 @@ Source code drawn from a number of sources and examples, including contributions
 #include "OpenAssetImportMesh.h"
 #include "Audio.h"
 #include "CCatmullRom.h"
+#include "EntityStore.h"
+#include "Simulation.h"
+#include "SimulationThread.h"
+#include "FramePacer.h"
+#include "Benchmark.h"
+#include "Headless.h"
 
 // Constructor
 Game::Game()
@@ -49,21 +57,22 @@ Game::Game()
 	m_ShipMesh = NULL;
 	m_pSphere = NULL;
 	m_pHighResolutionTimer = NULL;
+	m_pFramePacer = NULL;
 	m_pAudio = NULL;
 
-	m_dt = 0.0;
+	m_dt = 1000.0 / (double) Game::SIMULATION_RATE;
+	m_frameTime = 0.0;
 	m_framesPerSecond = 0;
+	m_appActive = false;
 	m_frameCount = 0;
 	m_elapsedTime = 0.0f;
 
 	m_pCatmullRom = NULL;
+	m_pSimulation = NULL;
+	m_pSimulationThread = NULL;
+	m_pOffscreenContext = NULL;
 
-	m_currentDistance = 20.0f;
-	//m_playerCurrentDistance = 0.01f;
-	m_cameraSpeed = 0.05f;
-
-	ringCout = 20;
-	scores = 0;
+	m_width = m_height = 0;
 }
 
 // Destructor
@@ -79,6 +88,9 @@ Game::~Game()
 	delete m_pSphere;
 	delete m_pAudio;
 
+	// The thread first, as it's still using the simulation and track
+	delete m_pSimulationThread;
+	delete m_pSimulation;
 	delete m_pCatmullRom;
 
 	if (m_pShaderPrograms != NULL) {
@@ -89,6 +101,10 @@ Game::~Game()
 
 	//setup objects
 	delete m_pHighResolutionTimer;
+	delete m_pFramePacer;
+
+	// Last, as the objects above free their GL resources in its context
+	delete m_pOffscreenContext;
 }
 
 // Initialisation:  This method only runs once at startup
@@ -98,14 +114,6 @@ void Game::Initialise()
 	glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
 	glClearDepth(1.0f);
 
-	zero_vector = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	camera_view = glm::vec3(0, 0.0f, 0.0f);
-	camera_upVector = glm::vec3(0.0f, 1.0f, 0.0f);
-
-	//curPlayerDir = glm::vec3(1, 0, 0);;
-
-	playerTOffset = 0;
 	// Create objects
 	m_pCamera = new CCamera;
 	m_pSkybox = new CSkybox;
@@ -115,16 +123,10 @@ void Game::Initialise()
 	m_RingMesh = new COpenAssetImportMesh;
 	m_ShipMesh = new COpenAssetImportMesh;
 	m_pSphere = new CSphere;
-	m_pAudio = new CAudio;
-
-	RECT dimensions = m_gameWindow.GetDimensions();
-
-	int width = dimensions.right - dimensions.left;
-	int height = dimensions.bottom - dimensions.top;
 
 	// Set the orthographic and perspective projection matrices based on the image size
-	m_pCamera->SetOrthographicProjectionMatrix(width, height); 
-	m_pCamera->SetPerspectiveProjectionMatrix(45.0f, (float) width / (float) height, 0.5f, 5000.0f);
+	m_pCamera->SetOrthographicProjectionMatrix(m_width, m_height); 
+	m_pCamera->SetPerspectiveProjectionMatrix(45.0f, (float) m_width / (float) m_height, 0.5f, 5000.0f);
 
 	// Load shaders
 	vector<CShader> shShaders;
@@ -133,6 +135,7 @@ void Game::Initialise()
 	sShaderFileNames.push_back("mainShader.frag");
 	sShaderFileNames.push_back("textShader.vert");
 	sShaderFileNames.push_back("textShader.frag");
+	sShaderFileNames.push_back("instancedShader.vert");
 
 	for (int i = 0; i < (int) sShaderFileNames.size(); i++) 
 	{
@@ -164,6 +167,14 @@ void Game::Initialise()
 	pFontProgram->LinkProgram();
 	m_pShaderPrograms->push_back(pFontProgram);
 
+	// Create the instanced shader program, which shares the main fragment shader
+	CShaderProgram *pInstancedProgram = new CShaderProgram;
+	pInstancedProgram->CreateProgram();
+	pInstancedProgram->AddShaderToProgram(&shShaders[4]);
+	pInstancedProgram->AddShaderToProgram(&shShaders[1]);
+	pInstancedProgram->LinkProgram();
+	m_pShaderPrograms->push_back(pInstancedProgram);
+
 	// You can follow this pattern to load additional shaders
 	// Create the skybox
 	// Skybox downloaded from http://www.akimbo.in/forum/viewtopic.php?f=10&t=9
@@ -183,78 +194,27 @@ void Game::Initialise()
 	m_pSphere->Create("resources\\textures\\", "dirtpile01.jpg", 25, 25);  // Texture downloaded from http://www.psionicgames.com/?page_id=26 on 24 Jan 2013
 	glEnable(GL_CULL_FACE);
 
-	// Initialise audio and play background music
-	m_pAudio->Initialise();
-	m_pAudio->LoadEventSound("Resources\\Audio\\Boing.wav");					// Royalty free sound from freesound.org
-	m_pAudio->LoadMusicStream("Resources\\Audio\\DST-Garote.mp3");	// Royalty free music from http://www.nosoapradio.us/
-	m_pAudio->PlayMusicStream();
+	// Initialise audio and play background music, unless rendering offscreen
+	if (m_pOffscreenContext == NULL) {
+		m_pAudio = new CAudio;
+		m_pAudio->Initialise();
+		m_pAudio->LoadEventSound("Resources\\Audio\\Boing.wav");					// Royalty free sound from freesound.org
+		m_pAudio->LoadMusicStream("Resources\\Audio\\DST-Garote.mp3");	// Royalty free music from http://www.nosoapradio.us/
+		m_pAudio->PlayMusicStream();
+	}
 
 	m_pCatmullRom = new CCatmullRom;
+	m_pCatmullRom->SetAdaptiveTessellation(2.0f, 0.02f, 20.0f);
+	m_pCatmullRom->LoadTrack("resources\\tracks\\default.track");
 	m_pCatmullRom->CreateCentreline();
 
 	m_pCatmullRom->CreateOffsetCurves();
 
 	m_pCatmullRom->CreateTrack();
 
-	AddRings();
-}
-
-void Game::AddRings()
-{
-	int m_vertexCount = (int)m_pCatmullRom->m_centrelinePoints.size();
-
-	int j = 0;
-
-	int max = 0;
-	int min = 0;
-	int range = 0;
-	int num = 0;
-	
-	for (size_t i = 0; i < ringCout && j < m_vertexCount-10; i++)
-	{
-		obstacleTf[i] = glm::mat4();
-		glm::vec3 point = m_pCatmullRom->m_centrelinePoints[j];
-
-		glm::vec3 T = glm::normalize(m_pCatmullRom->m_centrelinePoints[j+1] - point);
-		glm::vec3 N = glm::normalize(glm::cross(T, glm::vec3(0, 1, 0)));
-		glm::vec3 B = glm::normalize(glm::cross(N, T));
-
-		glm::vec3 OffsetN;
-
-		if(rand()%10 > 5)
-			OffsetN = glm::vec3(N.x * 3, N.y * 3, N.z * 3);
-		else
-			OffsetN = glm::vec3(N.x * -3, N.y * -3, N.z * -3);
-
-		obstacleTf[i] = glm::translate(point + glm::vec3(0, 1.5f, 0) + OffsetN);
-		glm::mat4 obstacle_orientation = glm::mat4(glm::mat3(T, B, N));
-
-		obstacleTf[i] *= obstacle_orientation;
-		
-		if (i < 3)
-		{
-			max = 100;
-			min = 80;
-			range = max - min + 1;
-			num = rand() % range + min;
-		}
-		else if (i >= 3 && i < 8)
-		{
-			max = 50;
-			min = 20;
-			range = max - min + 1;
-			num = rand() % range + min;
-		}
-		else
-		{
-			max = 20;
-			min = 10;
-			range = max - min + 1;
-			num = rand() % range + min;
-		}
-
-		j += num;
-	}
+	m_pSimulation = new CSimulation;
+	m_pSimulation->Initialise(m_pCatmullRom);
+	m_pSimulationThread = new CSimulationThread;
 }
 
 // Render method runs repeatedly in a loop
@@ -333,15 +293,27 @@ void Game::Render()
 		m_ShipMesh->Render();
 	modelViewMatrixStack.Pop();
 
-	for (size_t i = 0; i < ringCout; i++)
+	// Render the rings in one instanced draw, with the same light and materials as the main program
+	const vector<glm::mat4> &ringTransforms = m_pSimulationThread->GetFrame().ringTransforms;
+	if (!ringTransforms.empty())
 	{
-		// Render the barrel 
-		modelViewMatrixStack.Push();
-		modelViewMatrixStack.ApplyMatrix(obstacleTf[i]);
-		pMainProgram->SetUniform("matrices.modelViewMatrix", modelViewMatrixStack.Top());
-		pMainProgram->SetUniform("matrices.normalMatrix", m_pCamera->ComputeNormalMatrix(modelViewMatrixStack.Top()));
-		m_RingMesh->Render();
-		modelViewMatrixStack.Pop();
+		CShaderProgram *pInstancedProgram = (*m_pShaderPrograms)[2];
+		pInstancedProgram->UseProgram();
+		pInstancedProgram->SetUniform("bUseTexture", true);
+		pInstancedProgram->SetUniform("sampler0", 0);
+		pInstancedProgram->SetUniform("renderSkybox", false);
+		pInstancedProgram->SetUniform("matrices.projMatrix", m_pCamera->GetPerspectiveProjectionMatrix());
+		pInstancedProgram->SetUniform("matrices.viewMatrix", viewMatrix);
+		pInstancedProgram->SetUniform("light1.position", viewMatrix*lightPosition1);
+		pInstancedProgram->SetUniform("light1.La", glm::vec3(1.0f));
+		pInstancedProgram->SetUniform("light1.Ld", glm::vec3(1.0f));
+		pInstancedProgram->SetUniform("light1.Ls", glm::vec3(1.0f));
+		pInstancedProgram->SetUniform("material1.Ma", glm::vec3(0.5f));
+		pInstancedProgram->SetUniform("material1.Md", glm::vec3(0.5f));
+		pInstancedProgram->SetUniform("material1.Ms", glm::vec3(1.0f));
+		pInstancedProgram->SetUniform("material1.shininess", 15.0f);
+		m_RingMesh->RenderInstanced(&ringTransforms[0], ringTransforms.size());
+		pMainProgram->UseProgram();
 	}
 
 	// Render the sphere
@@ -390,7 +362,7 @@ void Game::Render()
 	pMainProgram->SetUniform("matrices.normalMatrix", m_pCamera->ComputeNormalMatrix(modelViewMatrixStack.Top()));
 	// To turn off texture mapping and use the sphere colour only (currently white material), uncomment the next line
 	//pMainProgram->SetUniform("bUseTexture", false);
-	m_pCatmullRom->RenderTrack();
+	m_pCatmullRom->RenderTrack(*m_pCamera->GetPerspectiveProjectionMatrix() * viewMatrix, m_pCamera->GetPosition());
 	modelViewMatrixStack.Pop();
 
 	// Draw the 2D graphics after the 3D graphics
@@ -399,7 +371,10 @@ void Game::Render()
 	UI();
 
 	// Swap buffers to show the rendered image
-	SwapBuffers(m_gameWindow.Hdc());		
+#ifdef _WIN32
+	if (m_pOffscreenContext == NULL)
+		SwapBuffers(m_gameWindow.Hdc());		
+#endif
 }
 
 float AngleBetweenVectors(glm::vec3 &V1, glm::vec3 &V2)
@@ -415,85 +390,47 @@ float AngleBetweenVectors(glm::vec3 &V1, glm::vec3 &V2)
 	return angle;
 }
 
-// Update method runs repeatedly with the Render method
-void Game::Update() 
+// Track editing keys (after F2): Page Up / Page Down raise and lower the control point nearest the player, Insert adds a point 
+// halfway to the one before it, and Delete removes it.  The simulation thread reads the track, so it's held while the track changes 
+// and the simulation re-indexes its rings against the new one.
+void Game::EditTrack(int key)
 {
-	// increment the distance by a fixed amount
-	m_currentDistance += m_dt * m_cameraSpeed;
-
-	if (m_currentDistance > 900)
+	if (!m_pCatmullRom->IsEditing())
 		return;
 
-	camera_position = glm::vec3();
-	// determine a point on the centreline, at a distance of m_currentDistance
-	m_pCatmullRom->Sample(m_currentDistance, camera_position);
-
-
-	//player_position
-	// determine player_position on the centreline, at a distance of m_currentDistance +1 
-	m_pCatmullRom->Sample(m_currentDistance + 8, player_position);
-
-	//tangentCamera
-	//a normalised tangent vector T that points from p to pNext
-	glm::vec3 tangentCamera = glm::normalize(player_position - camera_position);
-
-
-	// determine a point on the centreline
-	m_pCatmullRom->Sample(m_currentDistance + 9, player_lookAt);
-
-	//a normalised tangent vector T that points from p to pNext
-	glm::vec3 T = glm::normalize(player_lookAt- player_position);
-	glm::vec3 N = glm::normalize(glm::cross(T, glm::vec3(0, 1, 0)));
-	glm::vec3 B = glm::normalize(glm::cross(N, T));
-
-	player_orientation = glm::mat4(glm::mat3(T, B, N));
-
-	//m_playerCurrentDistance += m_dt * 0.001;
-	//glm::vec3 desiredPlayerDir = player_lookAt - player_position;
-	//lookAtAngle = AngleBetweenVectors(desiredPlayerDir, curPlayerDir);
-
-	debug = int(m_currentDistance);
-
-	playerTf = glm::mat4();
-	//playerTf = glm::lookAt(player_position, player_position+tmp, camera_upVector);
-	//playerTf = glm::translate(playerTf, glm::vec3(0, 0, 100));
-	
-	if (GetKeyState(VK_RIGHT) & 0x80 || GetKeyState('D') & 0x80)
-		playerTOffset += 0.01f*m_dt;
-
-	if (GetKeyState(VK_LEFT) & 0x80 || GetKeyState('A') & 0x80)
-		playerTOffset -= 0.01f*m_dt;
-
-	playerTOffset = glm::clamp(playerTOffset, -2.0f, 2.0f);
-
-	glm::vec3 offsetTVec = glm::vec3(N.x*playerTOffset, N.y*playerTOffset, N.z*playerTOffset);
-	player_position = player_position + offsetTVec;
-
-	playerTf = glm::translate(player_position);
-	playerTf = glm::scale(playerTf, glm::vec3(0.5f, 0.5f, 0.5f));
-	playerTf *= player_orientation;
-
-	//playerTf = glm::rotate(playerTf,lookAtAngle, glm::vec3(0, 1, 0));
+	m_pSimulationThread->Pause();
 
-	glm::vec4 vec(1.0f, 0.0f, 0.0f, 1.0f);
+	int i = m_pCatmullRom->NearestControlPoint(m_pSimulationThread->GetFrame().current.playerPosition);
+	glm::vec3 p = m_pCatmullRom->GetControlPoint(i);
+	glm::vec3 up(0.0f, 1.0f, 0.0f);
 
-	for (size_t i = 0; i < ringCout; i++)
-	{
-		glm::vec4 translationColumn = obstacleTf[i] * vec;
-		glm::vec3 obstacle_position = glm::vec3(translationColumn.x, translationColumn.y, translationColumn.z);
-		float player_distance = glm::length(obstacle_position - player_position);
-		if (player_distance < 2)
-		{
-			scores++;
-		    obstacleTf[i] = glm::mat4();
-		}
+	if (key == VK_PRIOR)
+		m_pCatmullRom->MoveControlPoint(i, p + glm::vec3(0.0f, 1.0f, 0.0f), up);
+	else if (key == VK_NEXT)
+		m_pCatmullRom->MoveControlPoint(i, p - glm::vec3(0.0f, 1.0f, 0.0f), up);
+	else if (key == VK_INSERT) {
+		int iPrev = (i - 1 + m_pCatmullRom->GetNumControlPoints()) % m_pCatmullRom->GetNumControlPoints();
+		m_pCatmullRom->InsertControlPoint(i, 0.5f * (p + m_pCatmullRom->GetControlPoint(iPrev)), up);
 	}
+	else if (key == VK_DELETE)
+		m_pCatmullRom->RemoveControlPoint(i);
+
+	m_pSimulation->TrackChanged();
+	m_pSimulationThread->Resume();
+}
 
+// Update method runs repeatedly with the Render method.  It reads the keyboard for the simulation thread, which steps the 
+// simulation by m_dt on its own schedule, and updates the audio.
+void Game::Update() 
+{
+	SimulationInput input;
+	input.steer = 0.0f;
+	if (PlatformKeyDown(VK_RIGHT) || PlatformKeyDown('D'))
+		input.steer += 1.0f;
+	if (PlatformKeyDown(VK_LEFT) || PlatformKeyDown('A'))
+		input.steer -= 1.0f;
 
-	//yOffset of camera
-	glm::vec3 yOffset = glm::vec3(0, 3, 0);
-	//Follow camera to player
-	m_pCamera->Set(camera_position + yOffset, camera_position + 20.0f * tangentCamera, camera_upVector);
+	m_pSimulationThread->SetInput(input);
 
 	//Set camera at top View
 	//m_pCamera->Set(glm::vec3(-140.0f, 15.0f, 0.0f), glm::vec3(-140.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
@@ -502,33 +439,40 @@ void Game::Update()
 	//Update the camera using the amount of time that has elapsed to avoid framerate dependent motion
 	//m_pCamera->Update(m_dt);
 
-	m_pAudio->Update();
+	if (m_pAudio != NULL)
+		m_pAudio->Update();
+}
+
+// Set the camera and player transform to the state alpha of the way from the frame's previous snapshot to its current one
+void Game::ApplySnapshot(const FrameState &frame, float alpha)
+{
+	const GameSnapshot &s0 = frame.previous, &s1 = frame.current;
+	m_pCamera->Set(glm::mix(s0.cameraPosition, s1.cameraPosition, alpha), glm::mix(s0.cameraView, s1.cameraView, alpha), 
+		glm::mix(s0.cameraUpVector, s1.cameraUpVector, alpha));
+
+	playerTf = glm::translate(glm::mix(s0.playerPosition, s1.playerPosition, alpha));
+	playerTf = glm::scale(playerTf, glm::vec3(0.5f, 0.5f, 0.5f));
+	playerTf *= glm::mat4_cast(glm::mix(s0.playerOrientation, s1.playerOrientation, alpha));
 }
 
 void Game::UI()
 {
 	CShaderProgram *fontProgram = (*m_pShaderPrograms)[1];
 
-	RECT dimensions = m_gameWindow.GetDimensions();
-	int height = dimensions.bottom - dimensions.top;
-
 	fontProgram->UseProgram();
 	glDisable(GL_DEPTH_TEST);
 	fontProgram->SetUniform("matrices.modelViewMatrix", glm::mat4(1));
 	fontProgram->SetUniform("matrices.projMatrix", m_pCamera->GetOrthographicProjectionMatrix());
 	fontProgram->SetUniform("vColour", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-	m_pFtFont->Render(20, height - 80, 20, "Score: %d", scores);
+	m_pFtFont->Render(20, m_height - 80, 20, "Score: %d", m_pSimulationThread->GetFrame().score);
 }
 
 void Game::DisplayFrameRate()
 {
 	CShaderProgram *fontProgram = (*m_pShaderPrograms)[1];
 
-	RECT dimensions = m_gameWindow.GetDimensions();
-	int height = dimensions.bottom - dimensions.top;
-
 	// Increase the elapsed time and frame counter
-	m_elapsedTime += m_dt;
+	m_elapsedTime += m_frameTime;
 	m_frameCount++;
 
 	// Now we want to subtract the current time by the last time that was stored
@@ -550,41 +494,117 @@ void Game::DisplayFrameRate()
 		fontProgram->SetUniform("matrices.modelViewMatrix", glm::mat4(1));
 		fontProgram->SetUniform("matrices.projMatrix", m_pCamera->GetOrthographicProjectionMatrix());
 		fontProgram->SetUniform("vColour", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-		m_pFtFont->Render(20, height - 20, 20, "FPS: %d", m_framesPerSecond);
+		m_pFtFont->Render(20, m_height - 20, 20, "FPS: %d", m_framesPerSecond);
+		if (m_pFramePacer != NULL)
+			m_pFtFont->Render(20, m_height - 40, 20, "Pacing: %.2f ms late (max %.2f)", m_pFramePacer->GetAverageError(), m_pFramePacer->GetMaxError());
 	}
 }
 
-// The game loop runs repeatedly until game over
+// The game loop runs repeatedly until game over.  The pacer holds it to Game::FPS frames a second, sleeping in between.  The 
+// simulation thread steps in fixed steps of m_dt meanwhile; each frame, Render draws the latest step's state blended with the one 
+// before, by how far the clock has moved on towards the next step.
 void Game::GameLoop()
 {
-	// Fixed timer
-	m_dt = m_pHighResolutionTimer->Elapsed();
-	if (m_dt > 1000.0 / (double) Game::FPS) 
-	{
-		m_pHighResolutionTimer->Start();
+	m_pFramePacer->WaitForNextFrame();
+	m_frameTime = m_pHighResolutionTimer->Lap();
+
+	Update();
+
+	m_pSimulationThread->Acquire();
+	const FrameState &frame = m_pSimulationThread->GetFrame();
+	double sinceStep = (double) (PlatformCounter() - frame.publishTime) * 1000.0 / PlatformCounterFrequency();
+	ApplySnapshot(frame, (float) glm::min(sinceStep / m_dt, 1.0));
+	Render();
+}
+
+int Game::RunOffscreen(int numFrames, int width, int height, std::ostream &out)
+{
+	m_pHighResolutionTimer = new CHighResolutionTimer;
+#ifdef _WIN32
+	m_gameWindow.Init(m_hInstance);
+	if (!m_gameWindow.Hdc())
+		return 1;
+#endif
+	m_pOffscreenContext = new COffscreenContext;
+	if (!m_pOffscreenContext->Create(width, height))
+		return 1;
+	m_width = width;
+	m_height = height;
+
+	Initialise();
+	m_pSimulationThread->Start(m_pSimulation, m_dt, false);
+
+	out << "Rendering " << numFrames << " frames of " << width << "x" << height << " on " << m_pOffscreenContext->GetRenderer() 
+		<< std::endl;
+
+	// Each frame is one simulation step and a render, timed to the end of the GPU's work on it.  The simulation thread runs in 
+	// lockstep, making step N + 1 while step N is rendered, so a frame should take about the longer of the two, not their sum.
+	vector<double> frameTimes(numFrames);
+	double totalUpdateTime = 0.0, totalRenderTime = 0.0;
+	CHighResolutionTimer renderTimer;
+	m_pOffscreenContext->Bind();
+	m_pHighResolutionTimer->Start();
+	for (int i = 0; i < numFrames; i++) {
 		Update();
+		m_pSimulationThread->Acquire(true);
+		const FrameState &frame = m_pSimulationThread->GetFrame();
+		renderTimer.Start();
+		ApplySnapshot(frame, 1.0f);
 		Render();
+		m_pOffscreenContext->Finish();
+		totalRenderTime += renderTimer.Elapsed();
+		totalUpdateTime += frame.updateTime;
+		m_frameTime = frameTimes[i] = m_pHighResolutionTimer->Lap();
 	}
-	
-	// Variable timer
-	/*m_pHighResolutionTimer->Start();
-	Update();
-	Render();
-	m_dt = m_pHighResolutionTimer->Elapsed();*/
+	m_pSimulationThread->Stop();
+
+	double total = 0.0;
+	for (int i = 0; i < numFrames; i++)
+		total += frameTimes[i];
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	if (numFrames > 0) {
+		double mean = total / numFrames;
+		out << std::fixed << std::setprecision(3);
+		out << "update " << totalUpdateTime / numFrames << " ms, render " << totalRenderTime / numFrames << " ms, on " 
+			<< std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+		out << "frame mean " << mean << " ms, median " << frameTimes[numFrames / 2] << " ms, 99th percentile " 
+			<< frameTimes[(numFrames * 99) / 100] << " ms, worst " << frameTimes[numFrames - 1] << " ms" << std::endl;
+		out << std::setprecision(1) << 1000.0 / mean << " frames per second" << std::endl;
+	}
+
+	return 0;
 }
 
+Game& Game::GetInstance() 
+{
+	static Game instance;
+
+	return instance;
+}
+
+#ifdef _WIN32
+
 WPARAM Game::Execute() 
 {
 	m_pHighResolutionTimer = new CHighResolutionTimer;
+	m_pFramePacer = new CFramePacer;
+	m_pFramePacer->SetTargetInterval(1000.0 / (double) Game::FPS);
 	m_gameWindow.Init(m_hInstance);
 
 	if(!m_gameWindow.Hdc()) {
 		return 1;
 	}
 
+	RECT dimensions = m_gameWindow.GetDimensions();
+	m_width = dimensions.right - dimensions.left;
+	m_height = dimensions.bottom - dimensions.top;
+
 	Initialise();
+	m_pSimulationThread->Start(m_pSimulation, m_dt, true);
 
 	m_pHighResolutionTimer->Start();
+	m_pFramePacer->Reset();
 
 	
 	MSG msg;
@@ -603,6 +623,7 @@ WPARAM Game::Execute()
 		else Sleep(200); // Do not consume processor power if application isn't active
 	}
 
+	m_pSimulationThread->Stop();
 	m_gameWindow.Deinit();
 
 	return(msg.wParam);
@@ -622,9 +643,15 @@ LRESULT Game::ProcessEvents(HWND window,UINT message, WPARAM w_param, LPARAM l_p
 			case WA_CLICKACTIVE:
 				m_appActive = true;
 				m_pHighResolutionTimer->Start();
+				if (m_pFramePacer != NULL)		// RunOffscreen has no pacer
+					m_pFramePacer->Reset();
+				if (m_pSimulationThread != NULL)
+					m_pSimulationThread->Resume();
 				break;
 			case WA_INACTIVE:
 				m_appActive = false;
+				if (m_pSimulationThread != NULL)
+					m_pSimulationThread->Pause();
 				break;
 		}
 		break;
@@ -634,6 +661,8 @@ LRESULT Game::ProcessEvents(HWND window,UINT message, WPARAM w_param, LPARAM l_p
 			RECT dimensions;
 			GetClientRect(window, &dimensions);
 			m_gameWindow.SetDimensions(dimensions);
+			m_width = dimensions.right - dimensions.left;
+			m_height = dimensions.bottom - dimensions.top;
 		break;
 
 	case WM_PAINT:
@@ -649,10 +678,20 @@ LRESULT Game::ProcessEvents(HWND window,UINT message, WPARAM w_param, LPARAM l_p
 				PostQuitMessage(0);
 				break;
 			case '1':
-				m_pAudio->PlayEventSound();
-				break;
 			case VK_F1:
-				m_pAudio->PlayEventSound();
+				if (m_pAudio != NULL)
+					m_pAudio->PlayEventSound();
+				break;
+			case VK_F2:
+				m_pSimulationThread->Pause();
+				m_pCatmullRom->BeginEditing(16);
+				m_pSimulationThread->Resume();
+				break;
+			case VK_PRIOR:
+			case VK_NEXT:
+			case VK_INSERT:
+			case VK_DELETE:
+				EditTrack((int)w_param);
 				break;
 		}
 		break;
@@ -669,13 +708,6 @@ LRESULT Game::ProcessEvents(HWND window,UINT message, WPARAM w_param, LPARAM l_p
 	return result;
 }
 
-Game& Game::GetInstance() 
-{
-	static Game instance;
-
-	return instance;
-}
-
 void Game::SetHinstance(HINSTANCE hinstance) 
 {
 	m_hInstance = hinstance;
@@ -686,10 +718,68 @@ LRESULT CALLBACK WinProc(HWND window, UINT message, WPARAM w_param, LPARAM l_par
 	return Game::GetInstance().ProcessEvents(window, message, w_param, l_param);
 }
 
-int WINAPI WinMain(HINSTANCE hinstance, HINSTANCE, PSTR, int) 
+int WINAPI WinMain(HINSTANCE hinstance, HINSTANCE, PSTR cmdLine, int) 
 {
+	// "-benchmark" runs the CPU benchmarks in the console that launched us, without opening the game window
+	if (strstr(cmdLine, "-benchmark") != NULL) {
+		if (!AttachConsole(ATTACH_PARENT_PROCESS))
+			AllocConsole();
+		FILE *fp;
+		freopen_s(&fp, "CONOUT$", "w", stdout);
+		RunBenchmarks(std::cout);
+		return 0;
+	}
+
+	// "-headless N" steps the simulation N times as fast as it can, also without a window
+	const char *headless = strstr(cmdLine, "-headless");
+	if (headless != NULL) {
+		if (!AttachConsole(ATTACH_PARENT_PROCESS))
+			AllocConsole();
+		FILE *fp;
+		freopen_s(&fp, "CONOUT$", "w", stdout);
+		int numTicks = atoi(headless + strlen("-headless"));
+		return RunHeadless(numTicks > 0 ? numTicks : 100000, std::cout);
+	}
+
 	Game &game = Game::GetInstance();
 	game.SetHinstance(hinstance);
 
+	// "-frames N" renders N frames into a framebuffer in the window's context, without swapping, and reports the frame times
+	const char *frames = strstr(cmdLine, "-frames");
+	if (frames != NULL) {
+		if (!AttachConsole(ATTACH_PARENT_PROCESS))
+			AllocConsole();
+		FILE *fp;
+		freopen_s(&fp, "CONOUT$", "w", stdout);
+		int numFrames = atoi(frames + strlen("-frames"));
+		return game.RunOffscreen(numFrames > 0 ? numFrames : 1000, GameWindow::SCREEN_WIDTH, GameWindow::SCREEN_HEIGHT, std::cout);
+	}
+
 	return game.Execute();
 }
+
+#else
+
+// With no window system, the game can only run its benchmarks: "-benchmark" and "-headless N" as on Windows, or by default 
+// "-frames N", rendering N frames offscreen with Mesa's software rasterizer (unless LIBGL_ALWAYS_SOFTWARE is already set)
+int main(int argc, char **argv)
+{
+	int numFrames = 1000;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-benchmark") == 0) {
+			RunBenchmarks(std::cout);
+			return 0;
+		}
+		if (strcmp(argv[i], "-headless") == 0) {
+			int numTicks = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+			return RunHeadless(numTicks > 0 ? numTicks : 100000, std::cout);
+		}
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+			numFrames = atoi(argv[++i]);
+	}
+
+	setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+	return Game::GetInstance().RunOffscreen(numFrames, 800, 600, std::cout);
+}
+
+#endif
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Common.h"
+#ifdef _WIN32
 #include "GameWindow.h"
+#endif
+#include <ostream>
 
 // Classes used in game.  For a new class, declare it here and provide a pointer to an object of this class below.  Then, in Game.cpp, 
 // include the header.  In the Game constructor, set the pointer to NULL and in Game::Initialise, create a new object.  Don't forget to 
@@ -17,40 +20,16 @@ class CSphere;
 class COpenAssetImportMesh;
 class CAudio;
 class CCatmullRom;
+class CSimulation;
+class CFramePacer;
+class COffscreenContext;
+class CSimulationThread;
+struct FrameState;
 
 class Game 
 {
 private:
-	// The position of the camera's centre of projection
-	glm::vec3 camera_position;		
-	// The camera's viewpoint (point where the camera is looking)
-	glm::vec3 camera_view;
-	// The camera's up vector
-	glm::vec3 camera_upVector;			
-	//camera spped
-	float m_cameraSpeed;
-
-	//float m_playerCurrentDistance;
-	//float lookAtAngle;
-	//glm::vec3 curPlayerDir;
-
-	int debug;
-
-	glm::vec3 zero_vector;
-
-	//player current position
-	glm::vec3 player_position;
-	glm::mat4 player_orientation;
-	glm::vec3 player_lookAt;
-	glm::mat4 playerTf;
-	float playerTOffset = 0;
-
-	float ringCout;
-	glm::mat4 obstacleTf[20];
-
-	int scores;
-	// distance along the control path weve travelled
-	float m_currentDistance;
+	glm::mat4 playerTf;					// Set by ApplySnapshot for Render
 
 	// Some other member variables
 	double m_dt;
@@ -58,11 +37,17 @@ private:
 	bool m_appActive;
 
 	static const int FPS = 60;
+	static const int SIMULATION_RATE = 60;	// Update steps per second; m_dt is always the length of one step
+	double m_frameTime;						// Milliseconds since the last frame
 	int m_frameCount;
 	double m_elapsedTime;
 
+	int m_width, m_height;					// Of the window, or the offscreen framebuffer
+
+#ifdef _WIN32
 	GameWindow m_gameWindow;
 	HINSTANCE m_hInstance;
+#endif
 
 	// Pointers to game objects.  
 	//They will get allocated in Game::Initialise()
@@ -75,8 +60,12 @@ private:
 	COpenAssetImportMesh *m_ShipMesh;
 	CSphere *m_pSphere;
 	CHighResolutionTimer *m_pHighResolutionTimer;
+	CFramePacer *m_pFramePacer;
 	CAudio *m_pAudio;
 	CCatmullRom *m_pCatmullRom;
+	CSimulation *m_pSimulation;			// The camera, player, rings and score
+	CSimulationThread *m_pSimulationThread;	// Steps m_pSimulation while Render draws, and hands over each step's FrameState
+	COffscreenContext *m_pOffscreenContext;	// Rendered into instead of the window by RunOffscreen
 
 private:
 	// Three main methods used in the game.  Initialise runs once, while Update and Render run repeatedly in the game loop.
@@ -84,15 +73,22 @@ private:
 	void Update();
 	void Render();
 	void DisplayFrameRate();
-	void Game::AddRings();
+	void ApplySnapshot(const FrameState &frame, float alpha);
 	void UI();
+	void EditTrack(int key);
 	void GameLoop();
 
 public:
 	Game();
 	~Game();
 	static Game& GetInstance();
+#ifdef _WIN32
 	LRESULT ProcessEvents(HWND window,UINT message, WPARAM w_param, LPARAM l_param);
 	void SetHinstance(HINSTANCE hinstance);
 	WPARAM Execute();
+#endif
+
+	// Renders numFrames frames, one simulation step each, into a width x height framebuffer instead of the window, and writes 
+	// the frame times to out.  Audio is left off.  Returns nonzero if no GL context could be made.
+	int RunOffscreen(int numFrames, int width, int height, std::ostream &out);
 };
@@ -1,4 +1,4 @@
-#include "gamewindow.h"
+#include "GameWindow.h"
 
 #include "include/gl/glew.h"
 #include "include/gl/wglew.h"
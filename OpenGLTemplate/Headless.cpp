@@ -0,0 +1,52 @@
+#include "Headless.h"
+#include "Simulation.h"
+#include "CCatmullRom.h"
+#include "HighResolutionTimer.h"
+#include <iomanip>
+
+// Full steer one way for a second, then the other
+static SimulationInput ScriptedInput(int tick)
+{
+	SimulationInput input;
+	input.steer = (tick / 60) % 2 == 0 ? 1.0f : -1.0f;
+	return input;
+}
+
+int RunHeadless(int numTicks, std::ostream &out)
+{
+	const double dt = 1000.0 / 60.0;		// One step at Game::SIMULATION_RATE
+
+	// The same track as Game::Initialise, without the GPU buffers
+	CCatmullRom catmullRom;
+	catmullRom.SetAdaptiveTessellation(2.0f, 0.02f, 20.0f);
+	if (!catmullRom.LoadTrack("resources\\tracks\\default.track")) {
+		out << "Could not load resources\\tracks\\default.track" << std::endl;
+		return 1;
+	}
+
+	CSimulation simulation;
+	simulation.Initialise(&catmullRom);
+
+	int numRuns = 0;
+	int totalScore = 0;
+	CHighResolutionTimer timer;
+	timer.Start();
+	for (int tick = 0; tick < numTicks; tick++) {
+		simulation.Update(dt, ScriptedInput(tick));
+		if (simulation.IsFinished()) {
+			numRuns++;
+			totalScore += simulation.GetScore();
+			simulation.Restart();
+		}
+	}
+	double ms = timer.Elapsed();
+
+	out << "Headless simulation (" << numTicks << " ticks of " << std::fixed << std::setprecision(2) << dt << " ms)" << std::endl;
+	out << std::setw(24) << "time" << std::setw(16) << std::setprecision(1) << ms << " ms" << std::endl;
+	out << std::setw(24) << "ticks/second" << std::setw(16) << std::setprecision(0) << numTicks / (ms / 1000.0) << std::endl;
+	out << std::setw(24) << "faster than real time" << std::setw(16) << std::setprecision(0) << numTicks * dt / ms << "x" << std::endl;
+	out << std::setw(24) << "runs completed" << std::setw(16) << numRuns << std::endl;
+	if (numRuns > 0)
+		out << std::setw(24) << "mean score" << std::setw(16) << std::setprecision(2) << (double) totalScore / numRuns << std::endl;
+	return 0;
+}
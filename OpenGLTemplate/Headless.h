@@ -0,0 +1,9 @@
+#pragma once
+
+#include "Common.h"
+#include <ostream>
+
+// Runs the game's simulation with no window, GL context or audio, as fast as it will go, for profiling the gameplay code.  Run 
+// with "OpenGLTemplate.exe -headless N" to step N ticks of Game::SIMULATION_RATE per second.  The player is steered by a script, 
+// weaving from side to side, and each run restarts from the beginning when it reaches the end.  Results are written to out.
+int RunHeadless(int numTicks, std::ostream &out);
@@ -3,6 +3,7 @@
 CHighResolutionTimer::CHighResolutionTimer() :
 m_started(false)
 {
+	m_frequency = PlatformCounterFrequency();
 }
 
 CHighResolutionTimer::~CHighResolutionTimer()
@@ -12,7 +13,7 @@ CHighResolutionTimer::~CHighResolutionTimer()
 void CHighResolutionTimer::Start()
 {
 	m_started = true;
-	QueryPerformanceCounter(&m_t1);
+	m_t1 = PlatformCounter();
 }
 
 double CHighResolutionTimer::Elapsed()
@@ -20,9 +21,19 @@ double CHighResolutionTimer::Elapsed()
 	if (!m_started)
 		return 0.0;
 
-	LARGE_INTEGER frequency;
-	QueryPerformanceFrequency(&frequency);
+	m_t2 = PlatformCounter();
+	return (double) (m_t2 - m_t1) * 1000.0 / m_frequency;
+}
 
-	QueryPerformanceCounter(&m_t2);
-	return (double) (m_t2.QuadPart - m_t1.QuadPart) * 1000.0f / frequency.QuadPart;
-}
\ No newline at end of file
+double CHighResolutionTimer::Lap()
+{
+	if (!m_started) {
+		Start();
+		return 0.0;
+	}
+
+	m_t2 = PlatformCounter();
+	double elapsed = (double) (m_t2 - m_t1) * 1000.0 / m_frequency;
+	m_t1 = m_t2;
+	return elapsed;
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <windows.h>
+#include "Platform.h"
 
 class CHighResolutionTimer 
 {
@@ -10,8 +10,10 @@ public:
 
 	void Start();
 	double Elapsed();
+	double Lap();			// Milliseconds since Start or the last Lap, restarting from the same reading so no time is lost between laps
 
 private:
-	LARGE_INTEGER m_t1, m_t2;
+	long long m_t1, m_t2;
+	long long m_frequency;	// Fixed at boot, so read once rather than on every Elapsed
 	bool m_started;
 };
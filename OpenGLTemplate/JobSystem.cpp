@@ -0,0 +1,194 @@
+#include "JobSystem.h"
+
+// The deque each thread uses: its worker index, or 0 for threads that aren't workers
+static thread_local int t_queueIndex = 0;
+
+CJobSystem &CJobSystem::GetInstance()
+{
+	static CJobSystem instance;
+
+	return instance;
+}
+
+CJobSystem::CJobSystem() :
+m_started(false), m_running(false), m_numQueued(0)
+{
+	m_numThreads = 0;
+}
+
+CJobSystem::~CJobSystem()
+{
+	Stop();
+}
+
+void CJobSystem::SetNumThreads(int numThreads)
+{
+	numThreads = numThreads > 0 ? numThreads : 0;
+	if (numThreads == m_numThreads)
+		return;
+	Stop();
+	m_numThreads = numThreads;
+}
+
+int CJobSystem::GetNumThreads() const
+{
+	if (m_numThreads > 0)
+		return m_numThreads;
+
+	int numHardwareThreads = (int)std::thread::hardware_concurrency();
+	return numHardwareThreads > 0 ? numHardwareThreads : 1;
+}
+
+// The workers are started by the first job, so a game that never runs one has no idle threads
+void CJobSystem::Start()
+{
+	std::lock_guard<std::mutex> lock(m_startMutex);
+	if (m_started)
+		return;
+
+	int numThreads = GetNumThreads();
+	for (int i = 0; i < numThreads; i++)
+		m_queues.push_back(new JobQueue);
+
+	m_running = true;
+	for (int i = 1; i < numThreads; i++)
+		m_workers.push_back(std::thread(&CJobSystem::WorkerLoop, this, i));
+	m_started = true;
+}
+
+void CJobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_running = false;
+	}
+	m_wake.notify_all();
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+		m_workers[i].join();
+	m_workers.clear();
+
+	for (unsigned int i = 0; i < m_queues.size(); i++)
+		delete m_queues[i];
+	m_queues.clear();
+	m_numQueued = 0;
+	m_started = false;
+}
+
+void CJobSystem::Submit(const Job &job)
+{
+	if (job.pCounter != NULL)
+		job.pCounter->m_count++;
+	Push(job);
+}
+
+void CJobSystem::SubmitAfter(CJobCounter &dependency, const Job &job)
+{
+	// Counted now, so that waiting on the job's counter also waits for the job to be released and run
+	if (job.pCounter != NULL)
+		job.pCounter->m_count++;
+
+	{
+		std::lock_guard<std::mutex> lock(dependency.m_mutex);
+		if (!dependency.IsDone()) {
+			dependency.m_continuations.push_back(job);
+			return;
+		}
+	}
+	Push(job);
+}
+
+void CJobSystem::Wait(CJobCounter &counter)
+{
+	while (!counter.IsDone()) {
+		Job job;
+		if (FindJob(job))
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+
+	// The job that finished last may still be releasing the counter's lock, and the counter may be destroyed once this returns
+	std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void CJobSystem::Push(const Job &job)
+{
+	// With one thread there's no one to hand the job to
+	if (GetNumThreads() == 1) {
+		Execute(job);
+		return;
+	}
+	if (!m_started)
+		Start();
+
+	JobQueue *pQueue = m_queues[t_queueIndex];
+	{
+		std::lock_guard<std::mutex> lock(pQueue->mutex);
+		pQueue->jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_numQueued++;
+	}
+	m_wake.notify_one();
+}
+
+// Pop the newest job from this thread's deque, or steal the oldest from another's
+bool CJobSystem::FindJob(Job &job)
+{
+	int numQueues = (int)m_queues.size();
+	for (int i = 0; i < numQueues; i++) {
+		int index = (t_queueIndex + i) % numQueues;
+		JobQueue *pQueue = m_queues[index];
+		std::lock_guard<std::mutex> lock(pQueue->mutex);
+		if (pQueue->jobs.empty())
+			continue;
+
+		if (i == 0) {
+			job = pQueue->jobs.back();
+			pQueue->jobs.pop_back();
+		}
+		else {
+			job = pQueue->jobs.front();
+			pQueue->jobs.pop_front();
+		}
+		m_numQueued--;
+		return true;
+	}
+	return false;
+}
+
+void CJobSystem::Execute(const Job &job)
+{
+	job.function(job.pData, job.first, job.last);
+
+	CJobCounter *pCounter = job.pCounter;
+	if (pCounter == NULL)
+		return;
+
+	// The last job to finish releases the continuations.  The count only reaches zero under the lock, so SubmitAfter either sees 
+	// it there or leaves its job for this to release.
+	vector<Job> continuations;
+	{
+		std::lock_guard<std::mutex> lock(pCounter->m_mutex);
+		if (pCounter->m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			continuations.swap(pCounter->m_continuations);
+	}
+	for (unsigned int i = 0; i < continuations.size(); i++)
+		Push(continuations[i]);
+}
+
+void CJobSystem::WorkerLoop(int index)
+{
+	t_queueIndex = index;
+	while (m_running) {
+		Job job;
+		if (FindJob(job)) {
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this]() { return m_numQueued > 0 || !m_running; });
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+
+class CJobCounter;
+
+// A job runs function(pData, first, last).  pData must stay valid until the job has run.
+typedef void (*JobFunction)(void *pData, int first, int last);
+
+struct Job
+{
+	JobFunction function;
+	void *pData;
+	int first, last;
+	CJobCounter *pCounter;		// Counts down when the job finishes, or NULL
+};
+
+// Counts unfinished jobs, so that a thread can wait for a batch of them, and holds the jobs that are to run once they are done.  
+// Wait on a counter before destroying it.
+class CJobCounter
+{
+public:
+	CJobCounter() : m_count(0) {}
+	bool IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class CJobSystem;
+	CJobCounter(const CJobCounter&);
+	void operator=(const CJobCounter&);
+
+	std::atomic<int> m_count;
+	std::mutex m_mutex;				// Guards m_continuations, and the count reaching zero
+	vector<Job> m_continuations;
+};
+
+// A work-stealing scheduler, shared by the whole game.  Each thread has a deque of jobs: it pushes and pops its own jobs at the 
+// back, most recent first, while idle threads steal the oldest (usually the largest) from the front of others.  Threads that 
+// aren't workers, such as the GL thread, share deque 0, and help with any job while they Wait, so a loop run from the GL thread 
+// uses it as one of the threads.  Workers with nothing to do sleep until a job is submitted.
+//
+// Jobs report to a CJobCounter, which can be waited on or can release continuations, jobs submitted with SubmitAfter that run 
+// once the counter's jobs have finished.  Jobs can submit and wait on other jobs.
+class CJobSystem
+{
+public:
+	static CJobSystem &GetInstance();
+
+	// Threads, including whichever waits, used from now on.  0, the default, means one per hardware thread; 1 runs everything on 
+	// the thread that submits it.  Not while jobs are running.
+	void SetNumThreads(int numThreads);
+	int GetNumThreads() const;
+
+	void Submit(const Job &job);
+	void SubmitAfter(CJobCounter &dependency, const Job &job);	// Runs job once dependency's jobs have all finished
+	void Wait(CJobCounter &counter);		// Runs jobs (any jobs) until counter's have all finished
+
+	// Call f(first, last) on consecutive ranges that together cover [begin, end), as jobs, waiting for them all.  There are a 
+	// few ranges per thread, so that threads that finish early can steal from the others, but none shorter than minRange.
+	template <typename F> void ParallelFor(int begin, int end, int minRange, const F &f);
+
+private:
+	CJobSystem();
+	~CJobSystem();
+	CJobSystem(const CJobSystem&);
+	void operator=(const CJobSystem&);
+
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void Start();
+	void Stop();
+	void WorkerLoop(int index);
+	void Push(const Job &job);
+	bool FindJob(Job &job);
+	void Execute(const Job &job);
+
+	template <typename F> static void RunRange(void *pData, int first, int last)
+	{
+		(*(const F *)pData)(first, last);
+	}
+
+	int m_numThreads;
+	std::atomic<bool> m_started;
+	std::mutex m_startMutex;
+	vector<JobQueue *> m_queues;			// One per thread; 0 is for threads that aren't workers
+	vector<std::thread> m_workers;
+	std::atomic<bool> m_running;
+	std::atomic<int> m_numQueued;			// Jobs in all the queues together
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+};
+
+template <typename F> void CJobSystem::ParallelFor(int begin, int end, int minRange, const F &f)
+{
+	int n = end - begin;
+	if (n <= 0)
+		return;
+
+	int numRanges = 4 * GetNumThreads();
+	if (GetNumThreads() == 1)
+		numRanges = 1;
+	if (minRange > 0 && n / minRange < numRanges)
+		numRanges = n / minRange;
+	if (numRanges <= 1) {
+		f(begin, end);
+		return;
+	}
+
+	CJobCounter counter;
+	Job job;
+	job.function = &CJobSystem::RunRange<F>;
+	job.pData = (void *)&f;
+	job.pCounter = &counter;
+
+	// Pushed last first, so that this thread, popping from the back, starts at the beginning
+	for (int r = numRanges - 1; r >= 0; r--) {
+		job.first = begin + (int)((long long)n * r / numRanges);
+		job.last = begin + (int)((long long)n * (r + 1) / numRanges);
+		Submit(job);
+	}
+	Wait(counter);
+}
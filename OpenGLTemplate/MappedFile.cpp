@@ -0,0 +1,132 @@
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+CMappedFile::CMappedFile()
+{
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+	m_pData = NULL;
+	m_size = 0;
+}
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+bool CMappedFile::Open(const string &filename)
+{
+	Close();
+
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	// Empty files can't be mapped
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping == NULL) {
+		Close();
+		return false;
+	}
+
+	m_pData = (const BYTE*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_pData == NULL) {
+		Close();
+		return false;
+	}
+
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_pData != NULL)
+		UnmapViewOfFile(m_pData);
+	if (m_mapping != NULL)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+	m_pData = NULL;
+	m_size = 0;
+}
+
+#else
+
+CMappedFile::CMappedFile()
+{
+	m_file = -1;
+	m_pData = NULL;
+	m_size = 0;
+}
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+bool CMappedFile::Open(const string &filename)
+{
+	Close();
+
+	m_file = open(PlatformPath(filename).c_str(), O_RDONLY);
+	if (m_file < 0)
+		return false;
+
+	// Empty files can't be mapped
+	struct stat status;
+	if (fstat(m_file, &status) != 0 || status.st_size == 0) {
+		Close();
+		return false;
+	}
+
+	void *pData = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (pData == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	m_pData = (const BYTE*)pData;
+	m_size = (size_t)status.st_size;
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_pData != NULL)
+		munmap((void*)m_pData, m_size);
+	if (m_file >= 0)
+		close(m_file);
+
+	m_file = -1;
+	m_pData = NULL;
+	m_size = 0;
+}
+
+#endif
+
+const BYTE *CMappedFile::GetData() const
+{
+	return m_pData;
+}
+
+size_t CMappedFile::GetSize() const
+{
+	return m_size;
+}
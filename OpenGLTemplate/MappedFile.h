@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Common.h"
+
+// A read-only view of a whole file, mapped into memory so its contents can be used in place without being read into a buffer
+class CMappedFile
+{
+public:
+	CMappedFile();
+	~CMappedFile();
+
+	bool Open(const string &filename);	// False if the file doesn't exist or can't be mapped
+	void Close();
+
+	const BYTE *GetData() const;		// NULL if no file is open
+	size_t GetSize() const;
+
+private:
+#ifdef _WIN32
+	HANDLE m_file;
+	HANDLE m_mapping;
+#else
+	int m_file;
+#endif
+	const BYTE *m_pData;
+	size_t m_size;
+};
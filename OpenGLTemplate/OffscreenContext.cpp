@@ -0,0 +1,200 @@
+#include "OffscreenContext.h"
+
+#ifndef _WIN32
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
+
+COffscreenContext::COffscreenContext()
+{
+#ifndef _WIN32
+	m_display = NULL;
+	m_context = NULL;
+#endif
+	m_framebuffer = 0;
+	m_colourBuffer = 0;
+	m_depthBuffer = 0;
+	m_width = m_height = 0;
+}
+
+COffscreenContext::~COffscreenContext()
+{
+	Destroy();
+}
+
+bool COffscreenContext::Create(int width, int height)
+{
+	Destroy();
+	if (!CreateContext())
+		return false;
+
+	m_width = width;
+	m_height = height;
+
+	glGenRenderbuffers(1, &m_colourBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colourBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colourBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		char message[1024];
+		sprintf_s(message, "The %dx%d framebuffer is incomplete (status 0x%x)", width, height, status);
+		MessageBox(NULL, message, "Offscreen rendering", MB_ICONERROR);
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void COffscreenContext::Destroy()
+{
+	if (m_framebuffer != 0) {
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colourBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+	}
+	m_framebuffer = 0;
+	m_colourBuffer = 0;
+	m_depthBuffer = 0;
+	m_width = m_height = 0;
+
+	DestroyContext();
+}
+
+void COffscreenContext::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+}
+
+void COffscreenContext::Finish()
+{
+	glFinish();
+}
+
+int COffscreenContext::GetWidth() const
+{
+	return m_width;
+}
+
+int COffscreenContext::GetHeight() const
+{
+	return m_height;
+}
+
+string COffscreenContext::GetRenderer() const
+{
+	const char *renderer = (const char *) glGetString(GL_RENDERER);
+	return renderer != NULL ? renderer : "";
+}
+
+#ifdef _WIN32
+
+// The game window's context is already current
+bool COffscreenContext::CreateContext()
+{
+	if (wglGetCurrentContext() == NULL) {
+		MessageBox(NULL, "Open the game window before creating the framebuffer", "Offscreen rendering", MB_ICONERROR);
+		return false;
+	}
+	return true;
+}
+
+void COffscreenContext::DestroyContext()
+{}
+
+#else
+
+bool COffscreenContext::CreateContext()
+{
+	// The surfaceless platform needs no display server at all; older EGLs without it fall back on the default display
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT = 
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (eglGetPlatformDisplayEXT != NULL)
+		display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		MessageBox(NULL, "Couldn't initialise EGL", "Offscreen rendering", MB_ICONERROR);
+		return false;
+	}
+	m_display = display;
+
+	// Surfaceless displays have no window configs, which eglChooseConfig asks for by default
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+		MessageBox(NULL, "EGL has no desktop OpenGL config", "Offscreen rendering", MB_ICONERROR);
+		DestroyContext();
+		return false;
+	}
+
+	// The same version and profile as GameWindow::InitOpenGL
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 0,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	m_context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (m_context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, (EGLContext) m_context)) {
+		MessageBox(NULL, "OpenGL 4.0 is not supported!", "Offscreen rendering", MB_ICONERROR);
+		DestroyContext();
+		return false;
+	}
+
+	// glewInit also looks for a GLX display, and reports an error when there isn't one even though it has loaded the core 
+	// functions, so check for those instead
+	glewExperimental = GL_TRUE;
+	glewInit();
+	glGetError();
+	if (glGenFramebuffers == NULL || glGenVertexArrays == NULL || glVertexAttribDivisor == NULL) {
+		MessageBox(NULL, "Couldn't initialize GLEW!", "Offscreen rendering", MB_ICONERROR);
+		DestroyContext();
+		return false;
+	}
+
+	return true;
+}
+
+void COffscreenContext::DestroyContext()
+{
+	if (m_display != NULL) {
+		eglMakeCurrent((EGLDisplay) m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_context != NULL && m_context != EGL_NO_CONTEXT)
+			eglDestroyContext((EGLDisplay) m_display, (EGLContext) m_context);
+		eglTerminate((EGLDisplay) m_display);
+	}
+	m_display = NULL;
+	m_context = NULL;
+}
+
+#endif
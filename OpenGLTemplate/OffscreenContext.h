@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Common.h"
+
+// A framebuffer object to render into instead of a window, for measuring frame throughput on machines with no display.  On Linux 
+// Create also makes the GL context itself: an OpenGL 4.0 core context on a surfaceless EGL display (Mesa's 
+// EGL_MESA_platform_surfaceless), so no X server is needed, and with LIBGL_ALWAYS_SOFTWARE=1 it runs on the software rasterizer.  
+// On Windows the context comes from the game window, which must be open first.  Link with EGL on Linux.
+class COffscreenContext
+{
+public:
+	COffscreenContext();
+	~COffscreenContext();
+
+	bool Create(int width, int height);		// False, with a message, if there's no context or the framebuffer is incomplete
+	void Destroy();
+
+	void Bind();		// Direct rendering into the framebuffer, with the viewport covering it
+	void Finish();		// Wait for the frame's rendering to complete, as SwapBuffers would
+
+	int GetWidth() const;
+	int GetHeight() const;
+	string GetRenderer() const;		// GL_RENDERER, such as "llvmpipe (LLVM 15.0.7, 256 bits)"
+
+private:
+	bool CreateContext();
+	void DestroyContext();
+
+#ifndef _WIN32
+	void *m_display;		// EGLDisplay
+	void *m_context;		// EGLContext
+#endif
+	GLuint m_framebuffer;
+	GLuint m_colourBuffer;
+	GLuint m_depthBuffer;
+	int m_width, m_height;
+};
@@ -54,6 +54,8 @@ void COpenAssetImportMesh::MeshEntry::Init(const std::vector<Vertex>& Vertices,
 
 COpenAssetImportMesh::COpenAssetImportMesh()
 {
+    m_instanceVbo = INVALID_OGL_VALUE;
+    m_instanceCapacity = 0;
 }
 
 
@@ -69,6 +71,12 @@ void COpenAssetImportMesh::Clear()
         SAFE_DELETE(m_Textures[i]);
     }
 	glDeleteVertexArrays(1, &m_vao);
+
+    if (m_instanceVbo != INVALID_OGL_VALUE) {
+        glDeleteBuffers(1, &m_instanceVbo);
+        m_instanceVbo = INVALID_OGL_VALUE;
+        m_instanceCapacity = 0;
+    }
 }
 
 
@@ -80,7 +88,7 @@ bool COpenAssetImportMesh::Load(const std::string& Filename)
     bool Ret = false;
     Assimp::Importer Importer;
 
-    const aiScene* pScene = Importer.ReadFile(Filename.c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs);
+    const aiScene* pScene = Importer.ReadFile(PlatformPath(Filename).c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs);
     
     if (pScene) {
         Ret = InitFromScene(pScene, Filename);
@@ -145,7 +153,7 @@ void COpenAssetImportMesh::InitMesh(unsigned int Index, const aiMesh* paiMesh)
 bool COpenAssetImportMesh::InitMaterials(const aiScene* pScene, const std::string& Filename)
 {
     // Extract the directory part from the file name
-    std::string::size_type SlashIndex = Filename.find_last_of("\\");
+    std::string::size_type SlashIndex = Filename.find_last_of("\\/");
     std::string Dir;
 
     if (SlashIndex == std::string::npos) {
@@ -232,3 +240,59 @@ void COpenAssetImportMesh::Render()
     }
 
 }
+
+// Render NumInstances copies of the mesh, one per transform, with a single glDrawElementsInstanced per mesh entry.  The transforms 
+// go into a per instance buffer, read by instancedShader.vert as a mat4 attribute at locations 3 to 6 with a divisor of 1; 
+// the buffer is orphaned and refilled each call, so the upload doesn't wait on the last frame's draw, and grows by half again 
+// when it runs out of room.  The vertex attributes and texture are set up once per entry, rather than once per copy as calling Render would.
+void COpenAssetImportMesh::RenderInstanced(const glm::mat4 *pTransforms, unsigned int NumInstances)
+{
+    if (NumInstances == 0)
+        return;
+
+    glBindVertexArray(m_vao);
+
+    if (m_instanceVbo == INVALID_OGL_VALUE)
+        glGenBuffers(1, &m_instanceVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+    if (NumInstances > m_instanceCapacity)
+        m_instanceCapacity = NumInstances + NumInstances / 2;
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * m_instanceCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::mat4) * NumInstances, pTransforms);
+
+    for (unsigned int c = 0 ; c < 4 ; c++) {
+        glEnableVertexAttribArray(3 + c);
+        glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (const GLvoid*)(sizeof(glm::vec4) * c));
+        glVertexAttribDivisor(3 + c, 1);
+    }
+
+    for (unsigned int i = 0 ; i < m_Entries.size() ; i++) {
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glBindBuffer(GL_ARRAY_BUFFER, m_Entries[i].vbo);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)12);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)20);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Entries[i].ibo);
+
+        const unsigned int MaterialIndex = m_Entries[i].MaterialIndex;
+
+        if (MaterialIndex < m_Textures.size() && m_Textures[MaterialIndex]) 
+        {
+            m_Textures[MaterialIndex]->Bind(0);
+        }
+
+        glDrawElementsInstanced(GL_TRIANGLES, m_Entries[i].NumIndices, GL_UNSIGNED_INT, 0, NumInstances);
+        glDisableVertexAttribArray(0);
+        glDisableVertexAttribArray(1);
+        glDisableVertexAttribArray(2);
+    }
+
+    // Leave attributes 3 to 6 as Render expects them
+    for (unsigned int c = 0 ; c < 4 ; c++) {
+        glVertexAttribDivisor(3 + c, 0);
+        glDisableVertexAttribArray(3 + c);
+    }
+}
@@ -25,7 +25,7 @@
 #include "include/gl/glew.h"
 #include <Importer.hpp>      // C++ importer interface
 #include <scene.h>       // Output data structure
-#include <PostProcess.h> // Post processing flags
+#include <postprocess.h> // Post processing flags
 
 #include "Common.h"
 #include "Texture.h"
@@ -58,6 +58,7 @@ public:
     ~COpenAssetImportMesh();
     bool Load(const std::string& Filename);
     void Render();
+    void RenderInstanced(const glm::mat4 *pTransforms, unsigned int NumInstances);	// Draws a copy per transform, for instancedShader.vert
 
 private:
     bool InitFromScene(const aiScene* pScene, const std::string& Filename);
@@ -84,6 +85,8 @@ private:
     std::vector<MeshEntry> m_Entries;
     std::vector<CTexture*> m_Textures;
 	GLuint m_vao;
+    GLuint m_instanceVbo;				// Per instance model matrices for RenderInstanced
+    unsigned int m_instanceCapacity;	// Number of matrices m_instanceVbo has room for
 };
 
 
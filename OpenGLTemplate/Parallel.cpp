@@ -0,0 +1,11 @@
+#include "Parallel.h"
+
+void SetParallelThreadCount(int numThreads)
+{
+	CJobSystem::GetInstance().SetNumThreads(numThreads);
+}
+
+int GetParallelThreadCount()
+{
+	return CJobSystem::GetInstance().GetNumThreads();
+}
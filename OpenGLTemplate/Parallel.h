@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Common.h"
+#include "JobSystem.h"
+
+// Number of threads used by ParallelFor, and by the job system generally.  0, the default, means one per hardware thread; 1 runs 
+// everything on the calling thread.
+void SetParallelThreadCount(int numThreads);
+int GetParallelThreadCount();
+
+// Call f(first, last) on consecutive ranges that together cover [begin, end), as jobs on CJobSystem, with the calling thread 
+// helping until they are all done.  No range is shorter than minRange (except when the whole of [begin, end) is), so small loops 
+// stay serial.  f must only write to outputs that belong to its own range; then, since every element is computed by the same code 
+// whichever range it falls in, the results don't depend on the number of threads.
+template <typename F> void ParallelFor(int begin, int end, int minRange, const F &f)
+{
+	CJobSystem::GetInstance().ParallelFor(begin, end, minRange, f);
+}
@@ -0,0 +1,192 @@
+#include "Placement.h"
+#include "CCatmullRom.h"
+#include "Parallel.h"
+#include <algorithm>
+
+CPlacementGenerator::CPlacementGenerator()
+{
+	m_start = 0.0f;
+	m_end = 0.0f;
+	m_lateral = 0.0f;
+	m_height = 0.0f;
+	m_jitter = 0.0f;
+	m_chunkLength = 100.0f;
+}
+
+CPlacementGenerator::~CPlacementGenerator()
+{}
+
+void CPlacementGenerator::SetSeed(unsigned long long seed)
+{
+	m_random = CCounterRandom(seed);
+}
+
+void CPlacementGenerator::SetDensity(const vector<DensityKey> &keys)
+{
+	m_keys = keys;
+	BuildCumulative();
+}
+
+void CPlacementGenerator::SetRange(float fStart, float fEnd)
+{
+	m_start = fStart;
+	m_end = fEnd > fStart ? fEnd : fStart;
+	BuildCumulative();
+}
+
+void CPlacementGenerator::SetOffsets(float fLateral, float fHeight)
+{
+	m_lateral = fLateral;
+	m_height = fHeight;
+}
+
+void CPlacementGenerator::SetJitter(float fJitter)
+{
+	m_jitter = glm::clamp(fJitter, 0.0f, 1.0f);
+}
+
+void CPlacementGenerator::SetChunkLength(float fChunkLength)
+{
+	m_chunkLength = fChunkLength > 0.0f ? fChunkLength : 100.0f;
+}
+
+// Density at d, taking the value after the step where two keys share a distance
+static float DensityAt(const vector<DensityKey> &keys, float d)
+{
+	if (d <= keys.front().distance)
+		return keys.front().density;
+	if (d >= keys.back().distance)
+		return keys.back().density;
+	size_t j = 1;
+	while (keys[j].distance <= d)
+		j++;
+	const DensityKey &k0 = keys[j - 1], &k1 = keys[j];
+	return k0.density + (k1.density - k0.density) * (d - k0.distance) / (k1.distance - k0.distance);
+}
+
+// Breakpoints of the density over [m_start, m_end]: the ends, and every key between them with its own density, so that a step 
+// becomes two breakpoints at the same distance.  The count up to each one is by the trapezium rule, which is exact for a piecewise 
+// linear density.
+void CPlacementGenerator::BuildCumulative()
+{
+	m_curveDistances.clear();
+	m_curveDensities.clear();
+	m_curveCounts.clear();
+	if (m_keys.empty())
+		return;
+
+	m_curveDistances.push_back(m_start);
+	m_curveDensities.push_back(DensityAt(m_keys, m_start));
+	for (size_t i = 0; i < m_keys.size(); i++) {
+		if (m_keys[i].distance > m_start && m_keys[i].distance < m_end) {
+			m_curveDistances.push_back(m_keys[i].distance);
+			m_curveDensities.push_back(m_keys[i].density);
+		}
+	}
+	m_curveDistances.push_back(m_end);
+	m_curveDensities.push_back(DensityAt(m_keys, m_end));
+
+	m_curveCounts.push_back(0.0f);
+	for (size_t i = 1; i < m_curveDistances.size(); i++) {
+		float fLength = m_curveDistances[i] - m_curveDistances[i - 1];
+		float fDensity0 = glm::max(m_curveDensities[i - 1], 0.0f), fDensity1 = glm::max(m_curveDensities[i], 0.0f);
+		m_curveCounts.push_back(m_curveCounts.back() + 0.5f * fLength * (fDensity0 + fDensity1));
+	}
+}
+
+float CPlacementGenerator::GetExpectedCount() const
+{
+	return m_curveCounts.empty() ? 0.0f : m_curveCounts.back();
+}
+
+int CPlacementGenerator::GetNumChunks() const
+{
+	if (m_curveCounts.empty() || m_end <= m_start)
+		return 0;
+	return (int)ceilf((m_end - m_start) / m_chunkLength);
+}
+
+float CPlacementGenerator::CountAt(float d) const
+{
+	if (d <= m_start)
+		return 0.0f;
+	if (d >= m_end)
+		return m_curveCounts.back();
+
+	// The last breakpoint at or before d; its interval has non-zero length since d < m_end
+	size_t i = std::upper_bound(m_curveDistances.begin(), m_curveDistances.end(), d) - m_curveDistances.begin() - 1;
+	float fDensity0 = glm::max(m_curveDensities[i], 0.0f), fDensity1 = glm::max(m_curveDensities[i + 1], 0.0f);
+	float u = d - m_curveDistances[i];
+	float fSlope = (fDensity1 - fDensity0) / (m_curveDistances[i + 1] - m_curveDistances[i]);
+	return m_curveCounts[i] + fDensity0 * u + 0.5f * fSlope * u * u;
+}
+
+// The inverse of CountAt, for 0 <= fCount < GetExpectedCount().  Within an interval the count is a quadratic in the distance 
+// u from its start, fDensity0 u + fSlope u^2 / 2, solved in the form that stays accurate as fSlope goes to zero.
+float CPlacementGenerator::DistanceAtCount(float fCount) const
+{
+	size_t i = std::upper_bound(m_curveCounts.begin(), m_curveCounts.end(), fCount) - m_curveCounts.begin() - 1;
+	if (i + 1 >= m_curveCounts.size())
+		return m_end;
+
+	float fDensity0 = glm::max(m_curveDensities[i], 0.0f), fDensity1 = glm::max(m_curveDensities[i + 1], 0.0f);
+	float fSlope = (fDensity1 - fDensity0) / (m_curveDistances[i + 1] - m_curveDistances[i]);
+	float fRemaining = fCount - m_curveCounts[i];
+	float u = 2.0f * fRemaining / (fDensity0 + sqrtf(glm::max(fDensity0 * fDensity0 + 2.0f * fSlope * fRemaining, 0.0f)));
+	return glm::min(m_curveDistances[i] + u, m_curveDistances[i + 1]);
+}
+
+void CPlacementGenerator::PlaceItem(const CCatmullRom &spline, int k, float d, PlacedItem &item) const
+{
+	glm::vec3 p;
+	TrackFrame frame;
+	spline.Sample(d, p);
+	spline.SampleFrame(d, frame);
+
+	float fSide = m_random.Float(k, 1) < 0.5f ? -1.0f : 1.0f;
+	item.index = k;
+	item.distance = d;
+	item.position = p + glm::vec3(0.0f, m_height, 0.0f) + fSide * m_lateral * frame.N;
+	item.orientation = glm::quat_cast(glm::mat3(frame.T, frame.B, frame.N));
+}
+
+// Item k sits where the count reaches k + 1/2, moved by up to half of m_jitter either way, so it always lies in (k, k + 1) and the 
+// items come out in order.  The chunk takes the items whose count falls in its own share of the count.
+void CPlacementGenerator::GenerateChunk(const CCatmullRom &spline, int chunk, vector<PlacedItem> &items) const
+{
+	if (chunk < 0 || chunk >= GetNumChunks())
+		return;
+
+	float fCount0 = CountAt(m_start + chunk * m_chunkLength);
+	float fCount1 = chunk == GetNumChunks() - 1 ? GetExpectedCount() : CountAt(m_start + (chunk + 1) * m_chunkLength);
+
+	for (int k = glm::max((int)floorf(fCount0) - 1, 0); k <= (int)ceilf(fCount1); k++) {
+		float fCount = k + 0.5f + m_jitter * (m_random.Float(k, 0) - 0.5f);
+		if (fCount < fCount0 || fCount >= fCount1)
+			continue;
+
+		PlacedItem item;
+		PlaceItem(spline, k, DistanceAtCount(fCount), item);
+		items.push_back(item);
+	}
+}
+
+void CPlacementGenerator::Generate(const CCatmullRom &spline, vector<vector<PlacedItem> > &batches) const
+{
+	int numChunks = GetNumChunks();
+	batches.assign(numChunks, vector<PlacedItem>());
+	ParallelFor(0, numChunks, 1, [&](int first, int last) {
+		for (int c = first; c < last; c++)
+			GenerateChunk(spline, c, batches[c]);
+	});
+}
+
+void CPlacementGenerator::Generate(const CCatmullRom &spline, vector<PlacedItem> &items) const
+{
+	vector<vector<PlacedItem> > batches;
+	Generate(spline, batches);
+
+	items.clear();
+	for (size_t c = 0; c < batches.size(); c++)
+		items.insert(items.end(), batches[c].begin(), batches[c].end());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+#include "Random.h"
+#include "./include/glm/gtc/quaternion.hpp"
+
+class CCatmullRom;
+
+// Number of items per unit of track length at a distance along the track.  Density is linear between keys and constant beyond 
+// the first and last; two keys at the same distance make a step.
+struct DensityKey
+{
+	float distance;
+	float density;
+};
+
+// An item placed by CPlacementGenerator
+struct PlacedItem
+{
+	int index;					// Order along the track, from 0
+	float distance;				// Along the track
+	glm::vec3 position;
+	glm::quat orientation;		// Rotates the model's x, y and z to the track's T, B and N, as the rings are oriented
+};
+
+// Places rings or obstacles along a stretch of track, following a density curve, with random jitter in their spacing and a 
+// random side.  The curve's running integral counts items along the track, and item k goes where the count reaches k + 1/2 plus 
+// its jitter; everything random about item k comes from a counter-based generator keyed on k.  So each item depends only on the 
+// seed, the curve and the track, never on which other items have been generated, and the stretch can be split into fixed-length 
+// chunks generated independently and in parallel, giving the same layout for any number of threads.
+class CPlacementGenerator
+{
+public:
+	CPlacementGenerator();
+	~CPlacementGenerator();
+
+	void SetSeed(unsigned long long seed);
+	void SetDensity(const vector<DensityKey> &keys);	// Sorted by distance
+	void SetRange(float fStart, float fEnd);			// Items are placed between these distances
+	void SetOffsets(float fLateral, float fHeight);		// Each item is fLateral to the left or right of the centreline, and fHeight up
+	void SetJitter(float fJitter);						// 0 places items evenly by count; up to 1 moves each by up to half a spacing either way
+	void SetChunkLength(float fChunkLength);			// Length of track generated as one batch
+
+	int GetNumChunks() const;
+	float GetExpectedCount() const;						// Integral of the density over the range
+
+	void GenerateChunk(const CCatmullRom &spline, int chunk, vector<PlacedItem> &items) const;	// Appends the chunk's items, in order
+	void Generate(const CCatmullRom &spline, vector<vector<PlacedItem> > &batches) const;		// One batch per chunk, in parallel
+	void Generate(const CCatmullRom &spline, vector<PlacedItem> &items) const;				// Every item, in order
+
+private:
+	void BuildCumulative();
+	float CountAt(float d) const;			// Items expected between m_start and d
+	float DistanceAtCount(float fCount) const;
+	void PlaceItem(const CCatmullRom &spline, int k, float d, PlacedItem &item) const;
+
+	CCounterRandom m_random;
+	vector<DensityKey> m_keys;
+	float m_start, m_end;
+	float m_lateral, m_height;
+	float m_jitter;
+	float m_chunkLength;
+
+	// The density curve restricted to [m_start, m_end], with the running count at each key
+	vector<float> m_curveDistances;
+	vector<float> m_curveDensities;
+	vector<float> m_curveCounts;
+};
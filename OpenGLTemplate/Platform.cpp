@@ -0,0 +1,151 @@
+#include "Platform.h"
+
+#ifdef _WIN32
+
+#pragma comment(lib, "winmm.lib")
+
+std::string PlatformPath(const std::string &path)
+{
+	return path;
+}
+
+std::string PlatformFontPath(const std::string &name)
+{
+	char buf[512]; GetWindowsDirectory(buf, 512);
+	std::string sPath = buf;
+	sPath += "\\Fonts\\";
+	sPath += name;
+	return sPath;
+}
+
+long long PlatformCounter()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+long long PlatformCounterFrequency()
+{
+	// Fixed at boot, so only read once
+	static long long frequency = 0;
+	if (frequency == 0) {
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		frequency = f.QuadPart;
+	}
+	return frequency;
+}
+
+double PlatformProcessCpuMs()
+{
+	FILETIME creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	unsigned long long k = ((unsigned long long) kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+	unsigned long long u = ((unsigned long long) user.dwHighDateTime << 32) | user.dwLowDateTime;
+	return (k + u) / 10000.0;
+}
+
+void PlatformSleep(unsigned int ms)
+{
+	Sleep(ms);
+}
+
+void PlatformYield()
+{
+	SwitchToThread();
+}
+
+// Sleep normally rounds up to the 15.6 ms system tick
+bool PlatformBeginFineSleep()
+{
+	return timeBeginPeriod(1) == TIMERR_NOERROR;
+}
+
+void PlatformEndFineSleep()
+{
+	timeEndPeriod(1);
+}
+
+bool PlatformKeyDown(int key)
+{
+	return (GetKeyState(key) & 0x80) != 0;
+}
+
+#else
+
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+std::string PlatformPath(const std::string &path)
+{
+	std::string result = path;
+	for (size_t i = 0; i < result.size(); i++) {
+		if (result[i] == '\\')
+			result[i] = '/';
+	}
+	return result;
+}
+
+std::string PlatformFontPath(const std::string &name)
+{
+	const char *directories[] = { "/usr/share/fonts/truetype/msttcorefonts/", "/usr/share/fonts/TTF/", "/usr/share/fonts/truetype/", 
+		"/usr/local/share/fonts/" };
+	for (size_t i = 0; i < sizeof(directories) / sizeof(directories[0]); i++) {
+		std::string path = std::string(directories[i]) + name;
+		if (access(path.c_str(), R_OK) == 0)
+			return path;
+	}
+	return "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+}
+
+long long PlatformCounter()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+long long PlatformCounterFrequency()
+{
+	return 1000000000LL;
+}
+
+double PlatformProcessCpuMs()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+void PlatformSleep(unsigned int ms)
+{
+	timespec t;
+	t.tv_sec = ms / 1000;
+	t.tv_nsec = (long) (ms % 1000) * 1000000L;
+	nanosleep(&t, NULL);
+}
+
+void PlatformYield()
+{
+	sched_yield();
+}
+
+// nanosleep is already accurate to well under a millisecond
+bool PlatformBeginFineSleep()
+{
+	return true;
+}
+
+void PlatformEndFineSleep()
+{
+}
+
+bool PlatformKeyDown(int)
+{
+	return false;
+}
+
+#endif
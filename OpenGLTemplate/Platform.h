@@ -0,0 +1,137 @@
+#pragma once
+
+// The platform layer: everything the game needs from the operating system apart from its window, behind one set of functions with 
+// a Win32 implementation and a POSIX one (Linux), chosen by _WIN32.  On POSIX systems it also supplies the handful of Win32 types, 
+// key codes and secure CRT calls that the rest of the code uses, so that code compiles unchanged.
+
+#include <string>
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned int UINT;
+typedef uint32_t DWORD;
+#define TRUE 1
+#define FALSE 0
+
+// Messages go to stderr, there being no desktop to show them on
+#define MB_ICONHAND 0x10
+#define MB_ICONERROR MB_ICONHAND
+inline int MessageBox(void *, const char *text, const char *caption, unsigned int)
+{
+	fprintf(stderr, "%s: %s\n", caption, text);
+	return 0;
+}
+
+template <size_t N> inline int sprintf_s(char (&buffer)[N], const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(buffer, N, format, args);
+	va_end(args);
+	return n;
+}
+
+template <size_t N> inline int vsprintf_s(char (&buffer)[N], const char *format, va_list args)
+{
+	return vsnprintf(buffer, N, format, args);
+}
+
+// Like the CRT's, each %s, %c or %[ takes a buffer size after the buffer.  The sizes are dropped and the rest passed on to sscanf, 
+// so there only the width in the format limits what's written: give every one of those a width.  At most 16 values.
+inline int sscanf_s(const char *buffer, const char *format, ...)
+{
+	void *args[16] = { 0 };
+	int numArgs = 0;
+
+	va_list list;
+	va_start(list, format);
+	for (const char *p = format; *p != '\0'; p++) {
+		if (*p != '%')
+			continue;
+		p++;
+		if (*p == '%')
+			continue;
+		bool bSuppressed = *p == '*';
+		if (bSuppressed)
+			p++;
+		while ((*p >= '0' && *p <= '9') || *p == 'h' || *p == 'l' || *p == 'L' || *p == 'z' || *p == 'j' || *p == 't')
+			p++;
+		char conversion = *p;
+		if (conversion == '[') {
+			p++;
+			if (*p == '^')
+				p++;
+			if (*p == ']')
+				p++;
+			while (*p != '\0' && *p != ']')
+				p++;
+		}
+		if (conversion == '\0' || *p == '\0')
+			break;
+		if (bSuppressed)
+			continue;
+
+		void *arg = va_arg(list, void *);
+		if (numArgs < 16)
+			args[numArgs++] = arg;
+		if (conversion == 's' || conversion == 'c' || conversion == '[')
+			va_arg(list, unsigned int);
+	}
+	va_end(list);
+
+	return sscanf(buffer, format, args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7], args[8], args[9], args[10], 
+		args[11], args[12], args[13], args[14], args[15]);
+}
+
+inline int fopen_s(FILE **pFile, const char *filename, const char *mode)
+{
+	*pFile = fopen(filename, mode);
+	return *pFile == NULL ? -1 : 0;
+}
+
+// Virtual key codes for PlatformKeyDown, with their Win32 values
+#define VK_ESCAPE 0x1B
+#define VK_PRIOR 0x21
+#define VK_NEXT 0x22
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
+#define VK_INSERT 0x2D
+#define VK_DELETE 0x2E
+#define VK_F1 0x70
+#define VK_F2 0x71
+
+#endif
+
+// Resource paths in the code are written Windows style ("resources\\textures\\road.jpg"); this gives the path with the local 
+// separator.  The loaders (shaders, textures, meshes, fonts, tracks) all pass their paths through it.
+std::string PlatformPath(const std::string &path);
+
+// Full path of an installed TrueType font, such as "arial.ttf".  On POSIX systems a few usual font directories are searched, 
+// falling back on DejaVu Sans if the font isn't there.
+std::string PlatformFontPath(const std::string &name);
+
+// A monotonic high resolution counter (QueryPerformanceCounter, or clock_gettime(CLOCK_MONOTONIC)), and its ticks per second
+long long PlatformCounter();
+long long PlatformCounterFrequency();
+
+double PlatformProcessCpuMs();		// User and kernel time used by the process so far
+
+void PlatformSleep(unsigned int ms);
+void PlatformYield();				// Give up the rest of the time slice
+bool PlatformBeginFineSleep();		// Make PlatformSleep accurate to about a millisecond, if it isn't already
+void PlatformEndFineSleep();
+
+// Whether a key (a VK_ code, or an upper case letter or digit) is held down.  Always false where there's no keyboard to ask.
+bool PlatformKeyDown(int key);
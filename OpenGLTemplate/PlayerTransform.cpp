@@ -1,5 +1,4 @@
 #include "PlayerTransform.h"
-#include "gamewindow.h"
 
 PlayerTransform::PlayerTransform()
 {
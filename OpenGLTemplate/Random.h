@@ -0,0 +1,38 @@
+#pragma once
+
+// Counter-based random numbers: each value is a hash of (seed, counter, stream) rather than the next state of a generator, so any 
+// value can be computed directly, in any order and on any thread, and is always the same for the same inputs.  The hash is the 
+// SplitMix64 finaliser, applied twice so that nearby counters and streams give unrelated values.
+inline unsigned long long SplitMix64(unsigned long long x)
+{
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+class CCounterRandom
+{
+public:
+	CCounterRandom(unsigned long long seed = 0) : m_seed(SplitMix64(seed)) {}
+
+	// stream, below 256, picks one of several independent values for the same counter
+	unsigned long long Bits(unsigned long long counter, unsigned int stream = 0) const
+	{
+		return SplitMix64(m_seed ^ SplitMix64((counter << 8) ^ stream));
+	}
+
+	// Uniform in [0, 1), from the top 24 bits so that every value is exactly representable
+	float Float(unsigned long long counter, unsigned int stream = 0) const
+	{
+		return (float)(Bits(counter, stream) >> 40) * (1.0f / 16777216.0f);
+	}
+
+	float Float(unsigned long long counter, unsigned int stream, float fMin, float fMax) const
+	{
+		return fMin + (fMax - fMin) * Float(counter, stream);
+	}
+
+private:
+	unsigned long long m_seed;
+};
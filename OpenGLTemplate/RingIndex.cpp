@@ -0,0 +1,113 @@
+#include "RingIndex.h"
+#include "Collision.h"
+#include <algorithm>
+
+CRingIndex::CRingIndex()
+{
+	m_totalLength = 0.0f;
+}
+
+CRingIndex::~CRingIndex()
+{}
+
+void CRingIndex::Clear()
+{
+	m_totalLength = 0.0f;
+	m_distances.clear();
+	m_positions.clear();
+	m_ids.clear();
+	m_slots.clear();
+	m_active.clear();
+}
+
+void CRingIndex::Build(const vector<float> &distances, const vector<glm::vec3> &positions, float fTotalLength)
+{
+	vector<int> ids(distances.size());
+	for (unsigned int i = 0; i < ids.size(); i++)
+		ids[i] = (int)i;
+	Build(distances, positions, ids, fTotalLength);
+}
+
+void CRingIndex::Build(const vector<float> &distances, const vector<glm::vec3> &positions, const vector<int> &ids, float fTotalLength)
+{
+	Clear();
+	int n = (int)distances.size();
+	m_totalLength = fTotalLength;
+
+	// Sort the ids by distance, wrapped onto one lap, then lay the data out in that order
+	vector<pair<float, int> > order(n);
+	for (int i = 0; i < n; i++) {
+		float d = distances[i] - floorf(distances[i] / fTotalLength) * fTotalLength;
+		order[i] = make_pair(d, i);
+	}
+	std::sort(order.begin(), order.end());
+
+	int maxId = -1;
+	for (int i = 0; i < n; i++)
+		maxId = ids[i] > maxId ? ids[i] : maxId;
+
+	m_distances.resize(n);
+	m_positions.resize(n);
+	m_ids.resize(n);
+	m_slots.assign(maxId + 1, -1);
+	m_active.assign(n, 1);
+	for (int s = 0; s < n; s++) {
+		m_distances[s] = order[s].first;
+		m_positions[s] = positions[order[s].second];
+		m_ids[s] = ids[order[s].second];
+		m_slots[m_ids[s]] = s;
+	}
+}
+
+void CRingIndex::Remove(int id)
+{
+	if (id >= 0 && id < (int)m_slots.size() && m_slots[id] >= 0)
+		m_active[m_slots[id]] = 0;
+}
+
+int CRingIndex::GetSize() const
+{
+	return (int)m_ids.size();
+}
+
+// A stationary sweep, which SweepSphereSphere treats as a plain distance test
+void CRingIndex::FindNear(float d, const glm::vec3 &p, float fRadius, float fWindow, vector<int> &hits) const
+{
+	FindSwept(d, d, p, p, fRadius, fWindow, hits);
+}
+
+void CRingIndex::FindSwept(float d0, float d1, const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, float fWindow, vector<int> &hits) const
+{
+	if (m_distances.empty() || m_totalLength <= 0.0f)
+		return;
+
+	float fSpan = d1 - d0;
+	if (fSpan + 2.0f * fWindow >= m_totalLength) {
+		FindSweptInRange(0.0f, m_totalLength, p0, p1, fRadius, hits);
+		return;
+	}
+
+	// Split the window where it crosses the start of the lap
+	d0 -= floorf(d0 / m_totalLength) * m_totalLength;
+	float dLow = d0 - fWindow, dHigh = d0 + fSpan + fWindow;
+	if (dLow < 0.0f) {
+		FindSweptInRange(dLow + m_totalLength, m_totalLength, p0, p1, fRadius, hits);
+		dLow = 0.0f;
+	}
+	if (dHigh > m_totalLength) {
+		FindSweptInRange(0.0f, dHigh - m_totalLength, p0, p1, fRadius, hits);
+		dHigh = m_totalLength;
+	}
+	FindSweptInRange(dLow, dHigh, p0, p1, fRadius, hits);
+}
+
+void CRingIndex::FindSweptInRange(float d0, float d1, const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, vector<int> &hits) const
+{
+	int first = (int)(std::lower_bound(m_distances.begin(), m_distances.end(), d0) - m_distances.begin());
+	int last = (int)(std::upper_bound(m_distances.begin(), m_distances.end(), d1) - m_distances.begin());
+	float t;
+	for (int s = first; s < last; s++) {
+		if (m_active[s] && SweepSphereSphere(p0, p1, fRadius, m_positions[s], 0.0f, t))
+			hits.push_back(m_ids[s]);
+	}
+}
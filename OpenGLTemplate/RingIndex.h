@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Common.h"
+
+// Broadphase for collectibles and obstacles placed along the track.  Everything is sorted by its distance along the track, so the 
+// things near a player at a known track distance are a contiguous run found by binary search, and only those are tested.  The 
+// search window wraps around the end of the lap.  Items are identified by the ids given to Build (non-negative, such as 
+// CEntityStore ids), or by the order they were given in.
+class CRingIndex
+{
+public:
+	CRingIndex();
+	~CRingIndex();
+
+	// Index items at the given distances along a track of length fTotalLength, centred on the given positions
+	void Build(const vector<float> &distances, const vector<glm::vec3> &positions, float fTotalLength);
+	void Build(const vector<float> &distances, const vector<glm::vec3> &positions, const vector<int> &ids, float fTotalLength);
+	void Clear();
+	void Remove(int id);				// Leave an item out of future queries (once it has been collected, say)
+
+	// Ids of the items within fRadius of p whose track distance is within fWindow of d, appended to hits.  fWindow must be at least 
+	// fRadius plus however far along the track an item or the player can be from where its track distance puts it.
+	void FindNear(float d, const glm::vec3 &p, float fRadius, float fWindow, vector<int> &hits) const;
+
+	// Ids of the items touched by a sphere of radius fRadius swept from p0, at track distance d0, to p1, at d1 (d1 >= d0, and not 
+	// wrapped onto the lap), appended to hits.  Items count as spheres of radius zero, so this is FindNear along the segment; 
+	// fWindow is as for FindNear, added at both ends of [d0, d1].
+	void FindSwept(float d0, float d1, const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, float fWindow, vector<int> &hits) const;
+
+	int GetSize() const;
+
+private:
+	void FindSweptInRange(float d0, float d1, const glm::vec3 &p0, const glm::vec3 &p1, float fRadius, vector<int> &hits) const;
+
+	float m_totalLength;
+	vector<float> m_distances;			// Sorted
+	vector<glm::vec3> m_positions;		// In the same order as m_distances
+	vector<int> m_ids;
+	vector<int> m_slots;				// Where each id is in the sorted arrays, -1 if not indexed
+	vector<char> m_active;				// Per sorted slot; 0 once removed
+};
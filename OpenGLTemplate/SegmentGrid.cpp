@@ -0,0 +1,113 @@
+#include "SegmentGrid.h"
+#include <math.h>
+
+CSegmentGrid::CSegmentGrid()
+{
+	Clear();
+}
+
+CSegmentGrid::~CSegmentGrid()
+{}
+
+void CSegmentGrid::Clear()
+{
+	m_origin = glm::vec2(0.0f);
+	m_cellSize = 1.0f;
+	m_numCellsX = 0;
+	m_numCellsZ = 0;
+	m_cellStarts.clear();
+	m_items.clear();
+}
+
+void CSegmentGrid::Build(const vector<glm::vec3> &boundsMin, const vector<glm::vec3> &boundsMax)
+{
+	Clear();
+	int n = (int)boundsMin.size();
+	if (n == 0)
+		return;
+
+	// Overall extent, and the average size of a box, which becomes the cell size
+	glm::vec3 extentMin = boundsMin[0], extentMax = boundsMax[0];
+	float fAverageSize = 0.0f;
+	for (int i = 0; i < n; i++) {
+		extentMin = glm::min(extentMin, boundsMin[i]);
+		extentMax = glm::max(extentMax, boundsMax[i]);
+		glm::vec3 size = boundsMax[i] - boundsMin[i];
+		fAverageSize += size.x > size.z ? size.x : size.z;
+	}
+	fAverageSize /= n;
+
+	float fWidth = extentMax.x - extentMin.x, fDepth = extentMax.z - extentMin.z;
+	m_cellSize = fAverageSize > 1e-3f ? fAverageSize : 1.0f;
+	float fCells = (fWidth / m_cellSize + 1.0f) * (fDepth / m_cellSize + 1.0f);
+	if (fCells > (float)MAX_CELLS_PER_BOX * n)
+		m_cellSize *= sqrtf(fCells / (MAX_CELLS_PER_BOX * n));
+
+	m_origin = glm::vec2(extentMin.x, extentMin.z);
+	m_numCellsX = (int)(fWidth / m_cellSize) + 1;
+	m_numCellsZ = (int)(fDepth / m_cellSize) + 1;
+
+	// Count the boxes in each cell, turn the counts into starts, then fill in the lists
+	m_cellStarts.assign(m_numCellsX * m_numCellsZ + 1, 0);
+	for (int pass = 0; pass < 2; pass++) {
+		for (int i = 0; i < n; i++) {
+			int x0, z0, x1, z1;
+			FindCell(boundsMin[i], x0, z0);
+			FindCell(boundsMax[i], x1, z1);
+			for (int cz = z0; cz <= z1; cz++) {
+				for (int cx = x0; cx <= x1; cx++) {
+					int c = cz * m_numCellsX + cx;
+					if (pass == 0)
+						m_cellStarts[c + 1]++;
+					else
+						m_items[m_cellStarts[c + 1]++] = i;
+				}
+			}
+		}
+
+		if (pass == 0) {
+			for (int c = 0; c < m_numCellsX * m_numCellsZ; c++)
+				m_cellStarts[c + 1] += m_cellStarts[c];
+			m_items.resize(m_cellStarts.back());
+
+			// Shift down by one cell, so that the second pass's post-increment leaves each start where it began
+			for (int c = m_numCellsX * m_numCellsZ; c > 0; c--)
+				m_cellStarts[c] = m_cellStarts[c - 1];
+		}
+	}
+}
+
+bool CSegmentGrid::IsEmpty() const
+{
+	return m_items.empty();
+}
+
+float CSegmentGrid::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+int CSegmentGrid::GetNumCellsX() const
+{
+	return m_numCellsX;
+}
+
+int CSegmentGrid::GetNumCellsZ() const
+{
+	return m_numCellsZ;
+}
+
+void CSegmentGrid::FindCell(const glm::vec3 &p, int &cx, int &cz) const
+{
+	cx = (int)floorf((p.x - m_origin.x) / m_cellSize);
+	cz = (int)floorf((p.z - m_origin.y) / m_cellSize);
+	cx = cx < 0 ? 0 : (cx >= m_numCellsX ? m_numCellsX - 1 : cx);
+	cz = cz < 0 ? 0 : (cz >= m_numCellsZ ? m_numCellsZ - 1 : cz);
+}
+
+void CSegmentGrid::GetCell(int cx, int cz, const int *&pItems, int &count) const
+{
+	int c = cz * m_numCellsX + cx;
+	pItems = &m_items[0] + m_cellStarts[c];
+	count = m_cellStarts[c + 1] - m_cellStarts[c];
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Common.h"
+
+// A uniform grid over the XZ plane of a set of axis aligned boxes (the bounds of the track's spline segments), for finding the 
+// boxes near a point without testing them all.  Each cell lists the boxes that overlap it, stored contiguously per cell.  Height 
+// is ignored, since tracks are mostly laid out flat; callers still measure distances in 3D.
+class CSegmentGrid
+{
+public:
+	CSegmentGrid();
+	~CSegmentGrid();
+
+	// Bin boxes [boundsMin[i], boundsMax[i]].  The cell size is about the size of a typical box, enlarged if necessary so that 
+	// there are no more than a few cells per box.
+	void Build(const vector<glm::vec3> &boundsMin, const vector<glm::vec3> &boundsMax);
+	void Clear();
+
+	bool IsEmpty() const;
+	float GetCellSize() const;
+	int GetNumCellsX() const;
+	int GetNumCellsZ() const;
+	void FindCell(const glm::vec3 &p, int &cx, int &cz) const;	// Cell containing p, clamped to the grid
+	void GetCell(int cx, int cz, const int *&pItems, int &count) const;	// Boxes overlapping cell (cx, cz), which must be in the grid
+
+private:
+	static const int MAX_CELLS_PER_BOX = 4;
+
+	glm::vec2 m_origin;			// (x, z) of the corner of cell (0, 0)
+	float m_cellSize;
+	int m_numCellsX;
+	int m_numCellsZ;
+	vector<int> m_cellStarts;	// Cell c lists m_items[m_cellStarts[c]] to m_items[m_cellStarts[c + 1] - 1]
+	vector<int> m_items;
+};
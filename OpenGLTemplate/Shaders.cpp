@@ -1,5 +1,5 @@
 #include "Common.h"
-#include "shaders.h"
+#include "Shaders.h"
 
 
 
@@ -72,7 +72,7 @@ bool CShader::LoadShader(string sFile, int iType)
 bool CShader::GetLinesFromFile(string sFile, bool bIncludePart, vector<string>* vResult)
 {
 	FILE* fp;
-	fopen_s(&fp, sFile.c_str(), "rt");
+	fopen_s(&fp, PlatformPath(sFile).c_str(), "rt");
 	if(!fp)return false;
 
 	string sDirectory;
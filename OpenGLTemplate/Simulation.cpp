@@ -0,0 +1,229 @@
+#include "Simulation.h"
+#include "CCatmullRom.h"
+#include "SplineCursor.h"
+#include "EntityStore.h"
+#include "RingIndex.h"
+#include "Placement.h"
+
+CSimulation::CSimulation()
+{
+	m_pCatmullRom = NULL;
+	m_pCameraCursor = NULL;
+	m_pPlayerCursor = NULL;
+	m_pEntities = NULL;
+	m_pRings = NULL;
+
+	m_cameraSpeed = 0.05f;
+	m_numRings = 20;
+	m_ringSeed = 1;
+
+	m_currentDistance = 20.0f;
+	m_playerOffset = 0.0f;
+	m_previousPlayerDistance = m_currentDistance + 8;
+	m_cameraUpVector = glm::vec3(0.0f, 1.0f, 0.0f);
+	m_score = 0;
+}
+
+CSimulation::~CSimulation()
+{
+	delete m_pCameraCursor;
+	delete m_pPlayerCursor;
+	delete m_pEntities;
+	delete m_pRings;
+}
+
+void CSimulation::Initialise(CCatmullRom *pCatmullRom)
+{
+	m_pCatmullRom = pCatmullRom;
+
+	m_pCameraCursor = new CSplineCursor(m_pCatmullRom);
+	m_pPlayerCursor = new CSplineCursor(m_pCatmullRom);
+	m_pEntities = new CEntityStore;
+	m_pRings = new CRingIndex;
+
+	Restart();
+}
+
+void CSimulation::Restart()
+{
+	m_currentDistance = 20.0f;
+	m_playerOffset = 0.0f;
+	m_score = 0;
+
+	m_pEntities->Clear();
+	m_pRings->Clear();
+	AddRings();
+
+	m_previousPlayerDistance = m_currentDistance + 8;
+	m_pPlayerCursor->Sample(m_previousPlayerDistance, m_previousPlayerPosition);
+	m_playerPosition = m_previousPlayerPosition;
+}
+
+void CSimulation::AddRings()
+{
+	// Rings are spaced by distance along the track, so they don't depend on how finely the centreline is tessellated.  They start 
+	// out sparse, about 170 units apart over the first three, close up to about 68 apart over the next five, then come every 30 
+	// or so.  Each is 3 units to one side of the centreline, chosen at random, and 1.5 units up.
+	float fTotalLength = m_pCatmullRom->GetTotalLength();
+
+	vector<DensityKey> density;
+	DensityKey keys[] = { { 0.0f, 1.0f / 170.0f }, { 510.0f, 1.0f / 170.0f }, { 510.0f, 1.0f / 67.5f }, { 850.0f, 1.0f / 67.5f }, 
+		{ 850.0f, 1.0f / 30.0f } };
+	density.assign(keys, keys + sizeof(keys) / sizeof(keys[0]));
+
+	CPlacementGenerator placement;
+	placement.SetSeed(m_ringSeed);
+	placement.SetDensity(density);
+	placement.SetRange(0.0f, fTotalLength - 20.0f);
+	placement.SetOffsets(3.0f, 1.5f);
+	placement.SetJitter(0.5f);
+
+	vector<PlacedItem> items;
+	placement.Generate(*m_pCatmullRom, items);
+	if ((int)items.size() > m_numRings)
+		items.resize(m_numRings);
+
+	vector<float> ringDistances;
+	vector<glm::vec3> ringPositions;
+	vector<int> ringIds;
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		ringIds.push_back(m_pEntities->Create(ENTITY_RING, items[i].position, items[i].orientation, 1.0f));
+		ringDistances.push_back(items[i].distance);
+		ringPositions.push_back(items[i].position);
+	}
+
+	m_pRings->Build(ringDistances, ringPositions, ringIds, fTotalLength);
+}
+
+void CSimulation::Update(double dt, const SimulationInput &input)
+{
+	// increment the distance by a fixed amount
+	m_currentDistance += (float) dt * m_cameraSpeed;
+
+	if (IsFinished())
+		return;
+
+	// determine a point on the centreline, at a distance of m_currentDistance
+	glm::vec3 camera_position;
+	m_pCameraCursor->Sample(m_currentDistance, camera_position);
+
+	// determine the player's point on the centreline, at a distance of m_currentDistance + 8
+	glm::vec3 player_centre;
+	m_pPlayerCursor->Sample(m_currentDistance + 8, player_centre);
+
+	//a normalised tangent vector T that points from the camera to the player
+	glm::vec3 tangentCamera = glm::normalize(player_centre - camera_position);
+
+	//the player's frame: tangent T, sideways N and up B, from the precomputed rotation minimising frames
+	TrackFrame playerFrame;
+	m_pCatmullRom->SampleFrame(m_currentDistance + 8, playerFrame);
+	m_playerOrientation = glm::quat_cast(glm::mat3(playerFrame.T, playerFrame.B, playerFrame.N));
+
+	m_playerOffset += 0.01f * (float) dt * glm::clamp(input.steer, -1.0f, 1.0f);
+	m_playerOffset = glm::clamp(m_playerOffset, -2.0f, 2.0f);
+	m_playerPosition = player_centre + m_playerOffset * playerFrame.N;
+
+	// Pick up the rings the player passed within 2 units of anywhere between the last Update and this one, so that none are 
+	// missed at high speeds or low frame rates.  Only the rings near the player's stretch of track are tested; the window allows 
+	// for the player's and the rings' offsets to the side, which move them a little along the track on bends.
+	m_ringHits.clear();
+	m_pRings->FindSwept(m_previousPlayerDistance, m_currentDistance + 8, m_previousPlayerPosition, m_playerPosition, 2.0f, 10.0f, m_ringHits);
+	m_previousPlayerDistance = m_currentDistance + 8;
+	m_previousPlayerPosition = m_playerPosition;
+	for (size_t i = 0; i < m_ringHits.size(); i++)
+	{
+		m_score++;
+		m_pEntities->Kill(m_ringHits[i]);
+		m_pRings->Remove(m_ringHits[i]);
+	}
+	m_pEntities->Compact();
+
+	// Follow the player with the camera, 3 units up
+	m_cameraPosition = camera_position + glm::vec3(0, 3, 0);
+	m_cameraView = camera_position + 20.0f * tangentCamera;
+}
+
+// The rings stay where they are, but the track under them has moved and its length changed, so each live ring's distance along 
+// it is found again by projecting the ring onto the new centreline, and the ring index is rebuilt from those.  The cursors find 
+// their segments again on their own.
+void CSimulation::TrackChanged()
+{
+	if (m_pEntities == NULL)
+		return;
+
+	const glm::vec3 *positions = m_pEntities->GetPositions();
+	const unsigned char *types = m_pEntities->GetTypes();
+	const unsigned char *alive = m_pEntities->GetAlive();
+	const int *ids = m_pEntities->GetIds();
+
+	vector<float> ringDistances;
+	vector<glm::vec3> ringPositions;
+	vector<int> ringIds;
+	for (int i = 0; i < m_pEntities->GetCount(); i++)
+	{
+		TrackProjection projection;
+		if (types[i] != ENTITY_RING || !alive[i] || !m_pCatmullRom->ProjectToTrack(positions[i], projection))
+			continue;
+		ringDistances.push_back(projection.distance);
+		ringPositions.push_back(positions[i]);
+		ringIds.push_back(ids[i]);
+	}
+
+	m_pRings->Build(ringDistances, ringPositions, ringIds, m_pCatmullRom->GetTotalLength());
+}
+
+bool CSimulation::IsFinished() const
+{
+	return m_currentDistance > 900;
+}
+
+int CSimulation::GetScore() const
+{
+	return m_score;
+}
+
+float CSimulation::GetDistance() const
+{
+	return m_currentDistance;
+}
+
+glm::vec3 CSimulation::GetPlayerPosition() const
+{
+	return m_playerPosition;
+}
+
+glm::quat CSimulation::GetPlayerOrientation() const
+{
+	return m_playerOrientation;
+}
+
+glm::vec3 CSimulation::GetCameraPosition() const
+{
+	return m_cameraPosition;
+}
+
+glm::vec3 CSimulation::GetCameraView() const
+{
+	return m_cameraView;
+}
+
+glm::vec3 CSimulation::GetCameraUpVector() const
+{
+	return m_cameraUpVector;
+}
+
+const CEntityStore *CSimulation::GetEntities() const
+{
+	return m_pEntities;
+}
+
+void CSimulation::SetNumRings(int numRings)
+{
+	m_numRings = numRings;
+}
+
+void CSimulation::SetRingSeed(unsigned long long seed)
+{
+	m_ringSeed = seed;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.h"
+#include "./include/glm/gtc/quaternion.hpp"
+
+class CCatmullRom;
+class CSplineCursor;
+class CEntityStore;
+class CRingIndex;
+
+// The player's controls for one simulation step, read from the keyboard by Game or made up by a script
+struct SimulationInput
+{
+	float steer;		// -1 to move left across the track at full speed, 1 for right, 0 to hold the line
+};
+
+// The gameplay state and rules, apart from any window, GL context, input device or audio: how far along the track the camera 
+// and player are, the player's place across the track, the rings and the score.  Game renders it and feeds it the keyboard; 
+// RunHeadless steps it as fast as it will go.  The track is shared, and must have been tessellated (LoadTrack does this).
+class CSimulation
+{
+public:
+	CSimulation();
+	~CSimulation();
+
+	void Initialise(CCatmullRom *pCatmullRom);	// Place the rings and start a run
+	void Restart();								// Start again from the beginning with a fresh set of rings
+	void Update(double dt, const SimulationInput &input);	// Advance by dt milliseconds
+	void TrackChanged();						// Re-index the rings by distance along the track after it has been edited
+	bool IsFinished() const;					// The camera has reached the end of the run; Update does nothing more
+
+	int GetScore() const;
+	float GetDistance() const;					// The camera's distance along the track
+	glm::vec3 GetPlayerPosition() const;
+	glm::quat GetPlayerOrientation() const;
+	glm::vec3 GetCameraPosition() const;
+	glm::vec3 GetCameraView() const;			// The point the camera looks at
+	glm::vec3 GetCameraUpVector() const;
+	const CEntityStore *GetEntities() const;
+
+	void SetNumRings(int numRings);
+	void SetRingSeed(unsigned long long seed);
+
+private:
+	void AddRings();
+
+	CCatmullRom *m_pCatmullRom;
+	CSplineCursor *m_pCameraCursor;		// Follows the track at m_currentDistance
+	CSplineCursor *m_pPlayerCursor;		// Follows the track just ahead of the camera, where the player is
+	CEntityStore *m_pEntities;			// Rings and obstacles
+	CRingIndex *m_pRings;				// The rings in m_pEntities, by distance along the track
+
+	float m_currentDistance;			// Distance along the control path we've travelled
+	float m_cameraSpeed;				// Units per millisecond
+	float m_playerOffset;				// Across the track, from -2 to 2
+
+	glm::vec3 m_playerPosition;
+	glm::quat m_playerOrientation;
+	glm::vec3 m_previousPlayerPosition;	// Where the player was last Update, the start of the swept ring test
+	float m_previousPlayerDistance;
+
+	glm::vec3 m_cameraPosition;
+	glm::vec3 m_cameraView;
+	glm::vec3 m_cameraUpVector;
+
+	int m_numRings;						// Rings placed by AddRings, at most
+	unsigned long long m_ringSeed;		// The ring layout is the same every time for the same seed
+	vector<int> m_ringHits;				// Scratch list for the ring collision query in Update
+	int m_score;
+};
@@ -0,0 +1,156 @@
+#include "SimulationThread.h"
+#include "EntityStore.h"
+#include "FramePacer.h"
+#include "HighResolutionTimer.h"
+
+CSimulationThread::CSimulationThread() :
+m_running(false), m_pauseRequested(false), m_paused(false), m_steer(0.0f), m_numPublished(0), m_numAcquired(0)
+{
+	m_pSimulation = NULL;
+	m_dt = 0.0;
+	m_paced = true;
+	m_numSteps = 0;
+}
+
+CSimulationThread::~CSimulationThread()
+{
+	Stop();
+}
+
+void CSimulationThread::Start(CSimulation *pSimulation, double dt, bool paced)
+{
+	Stop();
+
+	m_pSimulation = pSimulation;
+	m_dt = dt;
+	m_paced = paced;
+	m_numSteps = 0;
+	m_numPublished = 0;
+	m_numAcquired = 0;
+	m_pauseRequested = false;
+	m_paused = false;
+
+	// The first frame, with no motion to blend, so the renderer has something to draw straight away
+	TakeSnapshot(m_current);
+	FrameState &frame = m_frames.GetWriteBuffer();
+	frame.previous = m_current;
+	Publish(frame, PlatformCounter());
+
+	m_running = true;
+	m_thread = std::thread(&CSimulationThread::Run, this);
+}
+
+void CSimulationThread::Stop()
+{
+	if (!m_thread.joinable())
+		return;
+	m_running = false;
+	m_thread.join();
+}
+
+void CSimulationThread::Pause()
+{
+	m_pauseRequested = true;
+	while (m_running && !m_paused)
+		PlatformYield();
+}
+
+void CSimulationThread::Resume()
+{
+	m_pauseRequested = false;
+}
+
+void CSimulationThread::SetInput(const SimulationInput &input)
+{
+	m_steer.store(input.steer, std::memory_order_relaxed);
+}
+
+bool CSimulationThread::Acquire(bool bWait)
+{
+	while (!m_frames.Acquire()) {
+		if (!bWait || !m_running)
+			return false;
+		PlatformYield();
+	}
+	m_numAcquired++;
+	return true;
+}
+
+const FrameState &CSimulationThread::GetFrame() const
+{
+	return m_frames.GetReadBuffer();
+}
+
+void CSimulationThread::Run()
+{
+	CFramePacer pacer;
+	pacer.SetTargetInterval(m_dt);
+	CHighResolutionTimer clock;
+	clock.Start();
+	double accumulator = 0.0;
+
+	while (m_running) {
+		if (m_pauseRequested) {
+			m_paused = true;
+			while (m_running && m_pauseRequested)
+				PlatformSleep(1);
+			m_paused = false;
+
+			// The time paused isn't simulated
+			pacer.Reset();
+			clock.Start();
+			accumulator = 0.0;
+			continue;
+		}
+
+		if (m_paced) {
+			pacer.WaitForNextFrame();
+			accumulator += glm::min(clock.Lap(), 250.0);
+			while (accumulator >= m_dt && !m_pauseRequested) {
+				Step();
+				accumulator -= m_dt;
+			}
+		}
+		else if (m_numAcquired < m_numPublished)
+			PlatformYield();
+		else
+			Step();
+	}
+}
+
+void CSimulationThread::Step()
+{
+	long long startTime = PlatformCounter();
+
+	SimulationInput input;
+	input.steer = m_steer.load(std::memory_order_relaxed);
+	m_pSimulation->Update(m_dt, input);
+
+	FrameState &frame = m_frames.GetWriteBuffer();
+	frame.previous = m_current;
+	TakeSnapshot(m_current);
+	m_numSteps++;
+	Publish(frame, startTime);
+}
+
+void CSimulationThread::TakeSnapshot(GameSnapshot &snapshot) const
+{
+	snapshot.cameraPosition = m_pSimulation->GetCameraPosition();
+	snapshot.cameraView = m_pSimulation->GetCameraView();
+	snapshot.cameraUpVector = m_pSimulation->GetCameraUpVector();
+	snapshot.playerPosition = m_pSimulation->GetPlayerPosition();
+	snapshot.playerOrientation = m_pSimulation->GetPlayerOrientation();
+}
+
+// Fill in the rest of the frame from the simulation and hand it to the renderer.  startTime is when the step began.
+void CSimulationThread::Publish(FrameState &frame, long long startTime)
+{
+	frame.current = m_current;
+	m_pSimulation->GetEntities()->GetTransforms(ENTITY_RING, frame.ringTransforms);
+	frame.score = m_pSimulation->GetScore();
+	frame.step = m_numSteps;
+	frame.publishTime = PlatformCounter();
+	frame.updateTime = (double) (frame.publishTime - startTime) * 1000.0 / PlatformCounterFrequency();
+	m_frames.Publish();
+	m_numPublished++;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Common.h"
+#include "TripleBuffer.h"
+#include "Simulation.h"
+#include "./include/glm/gtc/quaternion.hpp"
+#include <thread>
+
+// The state Render draws, taken after each simulation step.  Render blends the last two, so that motion is smooth whatever the 
+// phase of the frames against the fixed simulation steps.
+struct GameSnapshot
+{
+	glm::vec3 cameraPosition;
+	glm::vec3 cameraView;
+	glm::vec3 cameraUpVector;
+	glm::vec3 playerPosition;
+	glm::quat playerOrientation;
+};
+
+// Everything the render thread needs from one simulation step, so that it never reads the simulation itself
+struct FrameState
+{
+	GameSnapshot previous;				// After the step before
+	GameSnapshot current;
+	vector<glm::mat4> ringTransforms;	// Model matrices of the live rings, for the instanced draw
+	int score;
+	int step;							// Steps since Start, 0 for the state Start found
+	long long publishTime;				// PlatformCounter when the step finished
+	double updateTime;					// Milliseconds the step took on the simulation thread
+};
+
+// Runs a CSimulation on a thread of its own, so that it computes the next step while the GL thread renders the last one, and a 
+// frame takes about as long as the slower of the two rather than both together.  Each step's FrameState is handed over in a 
+// CTripleBuffer, and the controls go the other way in an atomic, so neither thread blocks the other.  Paced, the thread steps in 
+// real time at 1 / dt, catching up after a stall as Game::GameLoop used to.  Otherwise it runs in lockstep with the renderer, 
+// making one step each time the last one has been acquired, which is what RunOffscreen uses to measure throughput.
+//
+// While the thread runs it owns the simulation and reads the track.  Pause it before changing either from another thread.
+class CSimulationThread
+{
+public:
+	CSimulationThread();
+	~CSimulationThread();
+
+	void Start(CSimulation *pSimulation, double dt, bool paced);	// Publishes the simulation's current state, then starts stepping
+	void Stop();
+
+	void Pause();		// Returns once the thread is waiting between steps
+	void Resume();
+
+	void SetInput(const SimulationInput &input);	// Used from the next step on
+
+	// Take the newest published frame, returning false if there's nothing newer than the current one.  With bWait, wait for one.
+	bool Acquire(bool bWait = false);
+	const FrameState &GetFrame() const;		// The frame last acquired
+
+private:
+	void Run();
+	void Step();
+	void TakeSnapshot(GameSnapshot &snapshot) const;
+	void Publish(FrameState &frame, long long startTime);
+
+	CSimulation *m_pSimulation;
+	double m_dt;
+	bool m_paced;
+	std::thread m_thread;
+
+	CTripleBuffer<FrameState> m_frames;
+	GameSnapshot m_current;					// The last step's snapshot, the next frame's previous one
+	int m_numSteps;
+
+	std::atomic<bool> m_running;
+	std::atomic<bool> m_pauseRequested;
+	std::atomic<bool> m_paused;
+	std::atomic<float> m_steer;
+	std::atomic<long long> m_numPublished;	// In lockstep, the thread waits for m_numAcquired to catch up before the next step
+	std::atomic<long long> m_numAcquired;
+};
@@ -1,6 +1,6 @@
 #include "Common.h"
 
-#include "skybox.h"
+#include "Skybox.h"
 
 
 CSkybox::CSkybox()
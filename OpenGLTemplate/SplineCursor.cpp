@@ -0,0 +1,95 @@
+#include "SplineCursor.h"
+#include "CCatmullRom.h"
+
+CSplineCursor::CSplineCursor()
+{
+	m_pSpline = NULL;
+	m_segment = 0;
+}
+
+CSplineCursor::CSplineCursor(const CCatmullRom *pSpline)
+{
+	Attach(pSpline);
+}
+
+CSplineCursor::~CSplineCursor()
+{}
+
+void CSplineCursor::Attach(const CCatmullRom *pSpline)
+{
+	m_pSpline = pSpline;
+	m_segment = 0;
+}
+
+int CSplineCursor::GetSegment() const
+{
+	return m_segment;
+}
+
+// Move m_segment to the segment containing d.  Moves of a few segments either way (forward is the usual case) are walked from the 
+// current segment; a move onto the next lap restarts the walk from segment 0, and anything else (a jump) uses the spline's binary search.
+bool CSplineCursor::Seek(float d, float &fLength)
+{
+	if (m_pSpline == NULL || d < 0)
+		return false;
+
+	int numSegments = m_pSpline->GetNumSegments();
+	if (numSegments == 0)
+		return false;
+
+	// The current length along the curve; handle the case where we've looped around the track
+	float fTotalLength = m_pSpline->GetTotalLength();
+	fLength = d - (int)(d / fTotalLength) * fTotalLength;
+
+	// The spline has lost segments since the last query
+	if (m_segment >= numSegments)
+		m_segment = 0;
+
+	// A short move backwards
+	for (int step = 0; step < MAX_WALK && m_segment > 0 && fLength < m_pSpline->GetSegmentStart(m_segment); step++)
+		m_segment--;
+
+	// Still behind: wrapped onto a new lap since the last query, or jumped back
+	if (fLength < m_pSpline->GetSegmentStart(m_segment))
+		m_segment = 0;
+
+	for (int step = 0; step < MAX_WALK && m_segment < numSegments; step++, m_segment++) {
+		if (fLength < m_pSpline->GetSegmentStart(m_segment + 1))
+			return true;
+	}
+
+	m_segment = m_pSpline->FindSegment(fLength);
+	if (m_segment == -1) {
+		m_segment = 0;
+		return false;
+	}
+
+	return true;
+}
+
+// Return the point on the centreline at a distance d along the curve
+bool CSplineCursor::Sample(float d, glm::vec3 &p)
+{
+	glm::vec3 up;
+	return Sample(d, p, up);
+}
+
+// Return the point (and upvector, if the spline has control upvectors) at a distance d along the curve
+bool CSplineCursor::Sample(float d, glm::vec3 &p, glm::vec3 &up)
+{
+	float fLength;
+	if (!Seek(d, fLength))
+		return false;
+
+	return m_pSpline->SampleSegment(m_segment, fLength, p, up);
+}
+
+// Return the point, tangent, normal and curvature at a distance d along the curve
+bool CSplineCursor::Sample(float d, SplineSample &sample)
+{
+	float fLength;
+	if (!Seek(d, fLength))
+		return false;
+
+	return m_pSpline->SampleSegment(m_segment, fLength, sample);
+}
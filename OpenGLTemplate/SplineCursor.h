@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Common.h"
+
+class CCatmullRom;
+struct SplineSample;
+
+// A read-only position on a CCatmullRom that remembers which segment it is on.  Successive queries at nearby distances (such as
+// a camera or player moving forward a little each frame) walk on from that segment, so they cost amortised O(1) rather than a 
+// search from the start of the track.  Cursors never modify the spline, so any number of them can follow the same track.
+class CSplineCursor
+{
+public:
+	CSplineCursor();
+	CSplineCursor(const CCatmullRom *pSpline);
+	~CSplineCursor();
+
+	void Attach(const CCatmullRom *pSpline);	// Follow a (different) spline, starting from its first segment
+
+	bool Sample(float d, glm::vec3 &p);						// Point on the centreline at a distance d along the curve
+	bool Sample(float d, glm::vec3 &p, glm::vec3 &up);		// Point and upvector at a distance d along the curve
+	bool Sample(float d, SplineSample &sample);				// Point, tangent, normal and curvature at a distance d along the curve
+
+	int GetSegment() const;						// Segment found by the last query
+
+private:
+	bool Seek(float d, float &fLength);			// Move to the segment containing d, returning the distance within the lap in fLength
+
+	static const int MAX_WALK = 8;				// Segments to step through before falling back to a binary search
+
+	const CCatmullRom *m_pSpline;
+	int m_segment;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Common.h"
+
+// Cubic a + b t + c t^2 + d t^3, t in [0, 1], for one segment of the spline
+struct SplineSegment
+{
+	glm::vec3 a, b, c, d;
+};
+
+// Parameterizations of the spline through the control points.  Each is a policy type with a static ComputeSegments that turns
+// four consecutive control points p[0..3] into the cubic between p[1] and p[2], and, if pUp isn't NULL, does the same for their
+// upvectors, using the same basis so that the upvectors stay in step with the points.  Everything except the knot spacing of the
+// non-uniform variants is a compile time constant, so each variant compiles down to its own fixed set of weights.  The segments
+// are evaluated from their coefficients, so sampling costs the same whichever parameterization built them.
+enum SplineParameterizationType
+{
+	SPLINE_UNIFORM,				// Catmull-Rom with equally spaced knots, the original curve
+	SPLINE_CENTRIPETAL,			// Catmull-Rom with knots spaced by the square root of the distance between points; no cusps or self intersections within a segment
+	SPLINE_CHORDAL,				// Catmull-Rom with knots spaced by the distance between points
+	SPLINE_KOCHANEK_BARTELS		// Tension, continuity and bias splines
+};
+
+// Cubic Hermite segment from p1 to p2 with end tangents m1 and m2
+inline SplineSegment HermiteSegment(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &m1, const glm::vec3 &m2)
+{
+	SplineSegment segment;
+	segment.a = p1;
+	segment.b = m1;
+	segment.c = -3.0f * p1 + 3.0f * p2 - 2.0f * m1 - m2;
+	segment.d = 2.0f * p1 - 2.0f * p2 + m1 + m2;
+	return segment;
+}
+
+// Tension, continuity and bias are only meaningful for Kochanek-Bartels, but every policy has them so that CCatmullRom can
+// record which curve it was built with
+struct SplineParameterizationBase
+{
+	static constexpr float TENSION = 0.0f;
+	static constexpr float CONTINUITY = 0.0f;
+	static constexpr float BIAS = 0.0f;
+};
+
+// The Catmull-Rom basis matrix, as the spline has always used
+struct UniformParameterization : SplineParameterizationBase
+{
+	static const int TYPE = SPLINE_UNIFORM;
+
+	static SplineSegment Segment(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3)
+	{
+		SplineSegment segment;
+		segment.a = p1;
+		segment.b = 0.5f * (-p0 + p2);
+		segment.c = 0.5f * (2.0f*p0 - 5.0f*p1 + 4.0f*p2 - p3);
+		segment.d = 0.5f * (-p0 + 3.0f*p1 - 3.0f*p2 + p3);
+		return segment;
+	}
+
+	static void ComputeSegments(const glm::vec3 *p, const glm::vec3 *pUp, SplineSegment &segment, SplineSegment &upSegment)
+	{
+		segment = Segment(p[0], p[1], p[2], p[3]);
+		if (pUp != NULL)
+			upSegment = Segment(pUp[0], pUp[1], pUp[2], pUp[3]);
+	}
+};
+
+// Knot intervals |p(i + 1) - p(i)|^alpha, from the squared distance between the points
+struct CentripetalKnots
+{
+	static const int TYPE = SPLINE_CENTRIPETAL;
+	static float Interval(float fDistanceSquared) { return sqrtf(sqrtf(fDistanceSquared)); }		// alpha = 0.5
+};
+
+struct ChordalKnots
+{
+	static const int TYPE = SPLINE_CHORDAL;
+	static float Interval(float fDistanceSquared) { return sqrtf(fDistanceSquared); }			// alpha = 1
+};
+
+// Catmull-Rom with knots spaced by Knots::Interval.  The tangents at p1 and p2 are those of the Barry-Goldman pyramid for the knot
+// sequence, rescaled to the segment's own [0, 1] parameter; both are weighted sums of the points, and the same weights are applied
+// to the upvectors.  Coincident points would give zero intervals, so those fall back to 1.
+template <typename Knots> struct NonUniformParameterization : SplineParameterizationBase
+{
+	static const int TYPE = Knots::TYPE;
+
+	static void ComputeSegments(const glm::vec3 *p, const glm::vec3 *pUp, SplineSegment &segment, SplineSegment &upSegment)
+	{
+		float dt[3];
+		for (int k = 0; k < 3; k++) {
+			dt[k] = Knots::Interval(glm::dot(p[k + 1] - p[k], p[k + 1] - p[k]));
+			if (dt[k] < 1e-4f)
+				dt[k] = 1.0f;
+		}
+
+		// m1 = w[0] p0 + w[1] p1 + w[2] p2 and m2 = v[0] p1 + v[1] p2 + v[2] p3
+		float w[3], v[3];
+		w[0] = dt[1] * (-1.0f / dt[0] + 1.0f / (dt[0] + dt[1]));
+		w[1] = dt[1] * (1.0f / dt[0] - 1.0f / dt[1]);
+		w[2] = dt[1] * (-1.0f / (dt[0] + dt[1]) + 1.0f / dt[1]);
+		v[0] = dt[1] * (-1.0f / dt[1] + 1.0f / (dt[1] + dt[2]));
+		v[1] = dt[1] * (1.0f / dt[1] - 1.0f / dt[2]);
+		v[2] = dt[1] * (-1.0f / (dt[1] + dt[2]) + 1.0f / dt[2]);
+
+		segment = HermiteSegment(p[1], p[2], w[0] * p[0] + w[1] * p[1] + w[2] * p[2], v[0] * p[1] + v[1] * p[2] + v[2] * p[3]);
+		if (pUp != NULL)
+			upSegment = HermiteSegment(pUp[1], pUp[2], w[0] * pUp[0] + w[1] * pUp[1] + w[2] * pUp[2], v[0] * pUp[1] + v[1] * pUp[2] + v[2] * pUp[3]);
+	}
+};
+
+typedef NonUniformParameterization<CentripetalKnots> CentripetalParameterization;
+typedef NonUniformParameterization<ChordalKnots> ChordalParameterization;
+
+// Kochanek-Bartels spline with the tension, continuity and bias of TCB, a type with static constexpr floats TENSION, CONTINUITY and
+// BIAS (all 0 gives the uniform Catmull-Rom curve).  The tangent weights are constant expressions.
+template <typename TCB> struct KochanekBartelsParameterization
+{
+	static const int TYPE = SPLINE_KOCHANEK_BARTELS;
+	static constexpr float TENSION = TCB::TENSION;
+	static constexpr float CONTINUITY = TCB::CONTINUITY;
+	static constexpr float BIAS = TCB::BIAS;
+
+	// m1 = K0 (p1 - p0) + K1 (p2 - p1) leaving p1, and m2 = K2 (p2 - p1) + K3 (p3 - p2) arriving at p2
+	static constexpr float K0 = 0.5f * (1.0f - TENSION) * (1.0f + BIAS) * (1.0f + CONTINUITY);
+	static constexpr float K1 = 0.5f * (1.0f - TENSION) * (1.0f - BIAS) * (1.0f - CONTINUITY);
+	static constexpr float K2 = 0.5f * (1.0f - TENSION) * (1.0f + BIAS) * (1.0f - CONTINUITY);
+	static constexpr float K3 = 0.5f * (1.0f - TENSION) * (1.0f - BIAS) * (1.0f + CONTINUITY);
+
+	static void ComputeSegments(const glm::vec3 *p, const glm::vec3 *pUp, SplineSegment &segment, SplineSegment &upSegment)
+	{
+		// Copied to locals, since glm takes scalars by reference and the constants have no out of class definitions
+		const float k0 = K0, k1 = K1, k2 = K2, k3 = K3;
+		segment = HermiteSegment(p[1], p[2], k0 * (p[1] - p[0]) + k1 * (p[2] - p[1]), k2 * (p[2] - p[1]) + k3 * (p[3] - p[2]));
+		if (pUp != NULL)
+			upSegment = HermiteSegment(pUp[1], pUp[2], k0 * (pUp[1] - pUp[0]) + k1 * (pUp[2] - pUp[1]), k2 * (pUp[2] - pUp[1]) + k3 * (pUp[3] - pUp[2]));
+	}
+};
+
+// Settings for KochanekBartelsParameterization: a slightly tightened curve, which rounds off bends less than Catmull-Rom
+struct TightTCB
+{
+	static constexpr float TENSION = 0.3f;
+	static constexpr float CONTINUITY = 0.0f;
+	static constexpr float BIAS = 0.0f;
+};
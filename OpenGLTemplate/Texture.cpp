@@ -1,8 +1,8 @@
 #include "Common.h"
 
-#include "texture.h"
+#include "Texture.h"
 
-#include "include\freeimage\FreeImage.h"
+#include "include/freeimage/FreeImage.h"
 #pragma comment(lib, "lib/FreeImage.lib")
 
 CTexture::CTexture()
@@ -41,6 +41,7 @@ bool CTexture::Load(string path, bool generateMipMaps)
 	FREE_IMAGE_FORMAT fif = FIF_UNKNOWN;
 	FIBITMAP* dib(0);
 
+	path = PlatformPath(path);
 	fif = FreeImage_GetFileType(path.c_str(), 0); // Check the file signature and deduce its format
 
 	if(fif == FIF_UNKNOWN) // If still unknown, try to guess the file format from the file extension
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Common.h"
+
+// Layout of a baked track cache file: a TrackCacheHeader, then the arrays listed in TrackCacheSection, each starting on a 16 byte 
+// boundary at the offset given in the header.  The file is memory mapped and the arrays are used straight from the mapping, so 
+// everything is stored in the in-memory layout of this build; the header records the sizes of the structures to catch mismatches.
+enum TrackCacheSection
+{
+	TRACK_CACHE_CENTRELINE_POINTS,		// glm::vec3 per centreline point
+	TRACK_CACHE_CENTRELINE_DISTANCES,	// float per centreline point
+	TRACK_CACHE_CENTRELINE_UPVECTORS,	// glm::vec3 per centreline point, or empty
+	TRACK_CACHE_CENTRELINE_FRAMES,		// TrackFrame per centreline point
+	TRACK_CACHE_SEGMENT_DISTANCES,		// float per segment, plus one (CCatmullRom::m_distances)
+	TRACK_CACHE_ARC_LENGTH_TABLE,		// float (CCatmullRom::m_arcLengthTable)
+	TRACK_CACHE_TRACK_VERTICES,			// TrackVertex
+	TRACK_CACHE_TRACK_INDICES,			// 16 or 32 bit indices, as given by indexSize
+	TRACK_CACHE_TRACK_CHUNKS,			// TrackChunk
+	TRACK_CACHE_NUM_SECTIONS
+};
+
+struct TrackCacheSectionInfo
+{
+	unsigned long long offset;		// From the start of the file
+	unsigned long long count;		// Number of elements
+};
+
+struct TrackCacheHeader
+{
+	static const unsigned int MAGIC = 0x4B415254;	// "TRAK"
+	static const unsigned int VERSION = 2;
+
+	unsigned int magic;
+	unsigned int version;
+	unsigned int vertexSize;		// sizeof(TrackVertex)
+	unsigned int frameSize;			// sizeof(TrackFrame)
+	unsigned int chunkSize;			// sizeof(TrackChunk)
+	unsigned int indexSize;			// 2 or 4
+	unsigned long long hash;		// Hash of the track source and the settings the cache was built with
+	unsigned long long contentHash;	// HashFNV1a of the sections' contents, in order, which catches damaged files
+	unsigned long long fileSize;	// Catches truncated files
+	unsigned int fullDetailIndexCount;
+	float pathWidth;
+	TrackCacheSectionInfo sections[TRACK_CACHE_NUM_SECTIONS];
+};
@@ -0,0 +1,98 @@
+#include "TrackFile.h"
+
+unsigned long long HashFNV1a(const void *pData, size_t size, unsigned long long hash)
+{
+	const BYTE *pByte = (const BYTE*)pData;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= pByte[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+CTrackFile::CTrackFile()
+{
+	m_pathWidth = 10.0f;
+	m_parameterization = SPLINE_UNIFORM;
+	m_hasTessellation = false;
+	m_adaptiveTessellation = false;
+	m_numUniformSamples = 500;
+	m_maxAngle = m_maxChordError = m_maxSpacing = 0.0f;
+	m_sourceHash = FNV_OFFSET_BASIS;
+}
+
+CTrackFile::~CTrackFile()
+{}
+
+bool CTrackFile::Load(const string &filename)
+{
+	FILE *fp;
+	if (fopen_s(&fp, PlatformPath(filename).c_str(), "rt") != 0 || fp == NULL)
+		return false;
+
+	m_controlPoints.clear();
+	m_controlUpVectors.clear();
+	m_sourceHash = FNV_OFFSET_BASIS;
+
+	bool bOk = true;
+	char line[256];
+	while (bOk && fgets(line, sizeof(line), fp)) {
+		m_sourceHash = HashFNV1a(line, strlen(line), m_sourceHash);
+
+		// Skip leading whitespace, blank lines and comments
+		char *p = line;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+			continue;
+
+		if (strncmp(p, "point", 5) == 0) {
+			glm::vec3 point, up;
+			int n = sscanf_s(p + 5, "%f %f %f %f %f %f", &point.x, &point.y, &point.z, &up.x, &up.y, &up.z);
+			if (n != 3 && n != 6)
+				bOk = false;
+			// Upvectors must be given for all of the points or none of them
+			else if (m_controlPoints.size() > 0 && (n == 6) != (m_controlUpVectors.size() > 0))
+				bOk = false;
+			else {
+				m_controlPoints.push_back(point);
+				if (n == 6)
+					m_controlUpVectors.push_back(glm::normalize(up));
+			}
+		}
+		else if (strncmp(p, "width", 5) == 0)
+			bOk = sscanf_s(p + 5, "%f", &m_pathWidth) == 1;
+		else if (strncmp(p, "parameterization", 16) == 0) {
+			char name[32] = "";
+			bOk = sscanf_s(p + 16, "%31s", name, (unsigned)sizeof(name)) == 1;
+			if (bOk) {
+				if (strcmp(name, "uniform") == 0)
+					m_parameterization = SPLINE_UNIFORM;
+				else if (strcmp(name, "centripetal") == 0)
+					m_parameterization = SPLINE_CENTRIPETAL;
+				else if (strcmp(name, "chordal") == 0)
+					m_parameterization = SPLINE_CHORDAL;
+				else if (strcmp(name, "tcb") == 0)
+					m_parameterization = SPLINE_KOCHANEK_BARTELS;
+				else
+					bOk = false;
+			}
+		}
+		else if (strncmp(p, "tessellation uniform", 20) == 0) {
+			bOk = sscanf_s(p + 20, "%d", &m_numUniformSamples) == 1 && m_numUniformSamples >= 3;
+			m_hasTessellation = true;
+			m_adaptiveTessellation = false;
+		}
+		else if (strncmp(p, "tessellation adaptive", 21) == 0) {
+			bOk = sscanf_s(p + 21, "%f %f %f", &m_maxAngle, &m_maxChordError, &m_maxSpacing) == 3 
+				&& m_maxAngle > 0.0f && m_maxChordError >= 0.0f && m_maxSpacing > 0.0f;
+			m_hasTessellation = true;
+			m_adaptiveTessellation = true;
+		}
+		else
+			bOk = false;
+	}
+	fclose(fp);
+
+	return bOk && m_controlPoints.size() >= 4;
+}
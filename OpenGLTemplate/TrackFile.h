@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Common.h"
+#include "SplineParameterization.h"
+
+// 64 bit FNV-1a hash of size bytes, continuing from hash (start with FNV_OFFSET_BASIS)
+static const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ULL;
+unsigned long long HashFNV1a(const void *pData, size_t size, unsigned long long hash = FNV_OFFSET_BASIS);
+
+// The text source of a track (see resources\tracks\default.track for the format): control points, optional upvectors, path width 
+// and tessellation setting
+class CTrackFile
+{
+public:
+	CTrackFile();
+	~CTrackFile();
+
+	bool Load(const string &filename);	// False if the file can't be read, has a malformed line, or has fewer than four points
+
+	vector<glm::vec3> m_controlPoints;
+	vector<glm::vec3> m_controlUpVectors;	// Empty, or one per control point
+	float m_pathWidth;
+	SplineParameterizationType m_parameterization;	// Uniform unless the file says otherwise
+
+	bool m_hasTessellation;				// Whether the file sets the tessellation; if not, the defaults stand
+	bool m_adaptiveTessellation;
+	int m_numUniformSamples;
+	float m_maxAngle, m_maxChordError, m_maxSpacing;
+
+	unsigned long long m_sourceHash;	// HashFNV1a of the whole file
+};
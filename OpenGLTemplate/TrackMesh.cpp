@@ -0,0 +1,345 @@
+#include "TrackMesh.h"
+#include "CCatmullRom.h"
+#include "Frustum.h"
+#include "Parallel.h"
+#include <algorithm>
+
+CTrackMesh::CTrackMesh()
+{
+	m_fullDetailIndexCount = 0;
+	m_pVertices = NULL;
+	m_numVertices = 0;
+	m_pIndices = NULL;
+	m_numIndices = 0;
+	m_indexSize = sizeof(unsigned short);
+	m_samplesPerBlock = 0;
+	m_blockCapacity = 0;
+	m_lod1Distance = 150.0f;
+	m_lod2Distance = 400.0f;
+}
+
+CTrackMesh::~CTrackMesh()
+{}
+
+void CTrackMesh::Clear()
+{
+	m_vertices.clear();
+	m_indices16.clear();
+	m_indices32.clear();
+	m_chunks.clear();
+	m_fullDetailIndexCount = 0;
+	m_pVertices = NULL;
+	m_numVertices = 0;
+	m_pIndices = NULL;
+	m_numIndices = 0;
+	m_indexSize = sizeof(unsigned short);
+	m_samplesPerBlock = 0;
+	m_blockCapacity = 0;
+}
+
+void CTrackMesh::Attach(const TrackVertex *pVertices, unsigned int numVertices, const void *pIndices, unsigned int numIndices, unsigned int indexSize, 
+	const TrackChunk *pChunks, unsigned int numChunks, unsigned int fullDetailIndexCount)
+{
+	Clear();
+
+	m_pVertices = pVertices;
+	m_numVertices = numVertices;
+	m_pIndices = pIndices;
+	m_numIndices = numIndices;
+	m_indexSize = indexSize;
+	m_chunks.assign(pChunks, pChunks + numChunks);
+	m_fullDetailIndexCount = fullDetailIndexCount;
+}
+
+// Fill in the vertices, split the samples into chunks, then write the indices for two triangles per quad, chunk by chunk and level 
+// by level.  Everything is written in place into storage sized up front.
+void CTrackMesh::Build(const vector<glm::vec3> &left, const vector<glm::vec3> &right, const vector<float> &distances, 
+	const vector<TrackFrame> &frames, float fTotalLength, float fTextureLength, float fChunkLength)
+{
+	Clear();
+
+	unsigned int M = (unsigned int)left.size();
+	if (M < 2 || right.size() != M || distances.size() != M || frames.size() != M)
+		return;
+
+	// Two vertices per sample, plus the first pair again at the end of the lap
+	m_vertices.resize(2 * (M + 1));
+	ParallelFor(0, M + 1, 4096, [&](int first, int last) {
+		for (unsigned int i = first; i < (unsigned int)last; i++) {
+			unsigned int k = i < M ? i : 0;
+			float u = (i < M ? distances[i] : fTotalLength) / fTextureLength;
+
+			TrackVertex &vl = m_vertices[2 * i];
+			vl.position = left[k];
+			vl.texCoord = glm::vec2(u, 0.0f);
+			vl.normal = frames[k].B;
+
+			TrackVertex &vr = m_vertices[2 * i + 1];
+			vr.position = right[k];
+			vr.texCoord = glm::vec2(u, 1.0f);
+			vr.normal = frames[k].B;
+		}
+	});
+
+	// Chunk c runs from sample chunkStarts[c] to chunkStarts[c + 1]; the last one ends on the seam pair M.  Samples are not evenly 
+	// spaced, so a chunk starts at each sample that falls in a later fChunkLength band than the one before it.  A sample interval 
+	// longer than fChunkLength skips the bands in between rather than leaving every later chunk a band behind.
+	vector<unsigned int> chunkStarts;
+	chunkStarts.push_back(0);
+	unsigned int currentBand = 0;
+	for (unsigned int i = 1; i < M; i++) {
+		unsigned int band = (unsigned int)(distances[i] / fChunkLength);
+		if (band != currentBand) {
+			chunkStarts.push_back(i);
+			currentBand = band;
+		}
+	}
+	vector<unsigned int> chunkEnds(chunkStarts.begin() + 1, chunkStarts.end());
+	chunkEnds.push_back(M);
+
+	unsigned int numChunks = (unsigned int)chunkStarts.size();
+	m_chunks.resize(numChunks);
+	ParallelFor(0, numChunks, 16, [&](int first, int last) {
+		for (int c = first; c < last; c++) {
+			TrackChunk &chunk = m_chunks[c];
+			chunk.startDistance = distances[chunkStarts[c]];
+			chunk.endDistance = chunkEnds[c] < M ? distances[chunkEnds[c]] : fTotalLength;
+			chunk.boundsMin = chunk.boundsMax = m_vertices[2 * chunkStarts[c]].position;
+			for (unsigned int v = 2 * chunkStarts[c]; v < 2 * chunkEnds[c] + 2; v++) {
+				chunk.boundsMin = glm::min(chunk.boundsMin, m_vertices[v].position);
+				chunk.boundsMax = glm::max(chunk.boundsMax, m_vertices[v].position);
+			}
+		}
+	});
+
+	m_pVertices = &m_vertices[0];
+	m_numVertices = (unsigned int)m_vertices.size();
+	if (m_vertices.size() <= 65536) {
+		BuildIndices(m_indices16, chunkStarts, chunkEnds, m_chunks);
+		m_pIndices = &m_indices16[0];
+		m_numIndices = (unsigned int)m_indices16.size();
+		m_indexSize = sizeof(unsigned short);
+	}
+	else {
+		BuildIndices(m_indices32, chunkStarts, chunkEnds, m_chunks);
+		m_pIndices = &m_indices32[0];
+		m_numIndices = (unsigned int)m_indices32.size();
+		m_indexSize = sizeof(unsigned int);
+	}
+}
+
+// Quad (a, b) joins the vertex pairs a and b, with the same winding as the original triangle list.  All the level 0 ranges come 
+// first, in chunk order, so the full detail track is a single range.
+template <typename T> void CTrackMesh::BuildIndices(vector<T> &indices, const vector<unsigned int> &chunkStarts, const vector<unsigned int> &chunkEnds, 
+	vector<TrackChunk> &chunks)
+{
+	unsigned int numChunks = (unsigned int)chunks.size();
+
+	// Count the quads first, so every chunk's ranges are known and the indices can be written straight into place, in parallel
+	unsigned int numIndices = 0;
+	for (int lod = 0; lod < TrackChunk::NUM_LODS; lod++) {
+		unsigned int stride = 1 << lod;
+		for (unsigned int c = 0; c < numChunks; c++) {
+			chunks[c].firstIndex[lod] = numIndices;
+			chunks[c].indexCount[lod] = 6 * ((chunkEnds[c] - chunkStarts[c] + stride - 1) / stride);
+			numIndices += chunks[c].indexCount[lod];
+		}
+		if (lod == 0)
+			m_fullDetailIndexCount = numIndices;
+	}
+
+	indices.resize(numIndices);
+	ParallelFor(0, numChunks, 16, [&](int first, int last) {
+		for (int c = first; c < last; c++) {
+			for (int lod = 0; lod < TrackChunk::NUM_LODS; lod++) {
+				unsigned int stride = 1 << lod;
+				T *pIndex = &indices[0] + chunks[c].firstIndex[lod];
+				for (unsigned int a = chunkStarts[c]; a < chunkEnds[c]; a += stride) {
+					unsigned int b = a + stride < chunkEnds[c] ? a + stride : chunkEnds[c];
+					T l0 = (T)(2 * a), r0 = (T)(2 * a + 1), l1 = (T)(2 * b), r1 = (T)(2 * b + 1);
+					pIndex[0] = l0;
+					pIndex[1] = r0;
+					pIndex[2] = l1;
+					pIndex[3] = l1;
+					pIndex[4] = r0;
+					pIndex[5] = r1;
+					pIndex += 6;
+				}
+			}
+		}
+	});
+}
+
+void CTrackMesh::BuildBlocks(unsigned int numBlocks, unsigned int capacity, unsigned int samplesPerBlock)
+{
+	Clear();
+
+	m_samplesPerBlock = samplesPerBlock;
+	m_blockCapacity = capacity > numBlocks ? capacity : numBlocks;
+	m_vertices.assign(m_blockCapacity * GetBlockVertexCount(), TrackVertex());
+	m_pVertices = &m_vertices[0];
+	m_numVertices = (unsigned int)m_vertices.size();
+	BuildBlockIndices();
+
+	SetNumBlocks(numBlocks);
+}
+
+// Indices for every block up to the capacity, and where each block's range at each level starts
+void CTrackMesh::BuildBlockIndices()
+{
+	vector<unsigned int> blockStarts(m_blockCapacity), blockEnds(m_blockCapacity);
+	for (unsigned int b = 0; b < m_blockCapacity; b++) {
+		blockStarts[b] = b * (m_samplesPerBlock + 1);
+		blockEnds[b] = blockStarts[b] + m_samplesPerBlock;
+	}
+
+	vector<TrackChunk> blocks(m_blockCapacity);
+	m_indices16.clear();
+	m_indices32.clear();
+	if (m_vertices.size() <= 65536) {
+		BuildIndices(m_indices16, blockStarts, blockEnds, blocks);
+		m_pIndices = &m_indices16[0];
+		m_numIndices = (unsigned int)m_indices16.size();
+		m_indexSize = sizeof(unsigned short);
+	}
+	else {
+		BuildIndices(m_indices32, blockStarts, blockEnds, blocks);
+		m_pIndices = &m_indices32[0];
+		m_numIndices = (unsigned int)m_indices32.size();
+		m_indexSize = sizeof(unsigned int);
+	}
+
+	for (int lod = 0; lod < TrackChunk::NUM_LODS; lod++) {
+		m_blockFirstIndex[lod] = blocks[0].firstIndex[lod];
+		m_blockIndexCount[lod] = blocks[0].indexCount[lod];
+	}
+}
+
+bool CTrackMesh::SetNumBlocks(unsigned int numBlocks)
+{
+	bool bGrown = false;
+	if (numBlocks > m_blockCapacity) {
+		m_blockCapacity = 2 * numBlocks;
+		m_vertices.resize(m_blockCapacity * GetBlockVertexCount());
+		m_pVertices = &m_vertices[0];
+		m_numVertices = (unsigned int)m_vertices.size();
+		BuildBlockIndices();
+		bGrown = true;
+	}
+
+	unsigned int oldNumBlocks = (unsigned int)m_chunks.size();
+	m_chunks.resize(numBlocks);
+	for (unsigned int b = bGrown ? 0 : oldNumBlocks; b < numBlocks; b++) {
+		for (int lod = 0; lod < TrackChunk::NUM_LODS; lod++) {
+			m_chunks[b].firstIndex[lod] = m_blockFirstIndex[lod] + b * m_blockIndexCount[lod];
+			m_chunks[b].indexCount[lod] = m_blockIndexCount[lod];
+		}
+	}
+	m_fullDetailIndexCount = numBlocks * m_blockIndexCount[0];
+
+	return bGrown;
+}
+
+unsigned int CTrackMesh::GetNumBlocks() const
+{
+	return (unsigned int)m_chunks.size();
+}
+
+unsigned int CTrackMesh::GetBlockVertexCount() const
+{
+	return 2 * (m_samplesPerBlock + 1);
+}
+
+TrackVertex *CTrackMesh::GetBlockVertices(unsigned int block)
+{
+	return &m_vertices[block * GetBlockVertexCount()];
+}
+
+void CTrackMesh::CopyBlock(unsigned int from, unsigned int to)
+{
+	unsigned int n = GetBlockVertexCount();
+	std::copy(m_vertices.begin() + from * n, m_vertices.begin() + (from + 1) * n, m_vertices.begin() + to * n);
+
+	TrackChunk &chunk = m_chunks[to];
+	chunk.boundsMin = m_chunks[from].boundsMin;
+	chunk.boundsMax = m_chunks[from].boundsMax;
+	chunk.startDistance = m_chunks[from].startDistance;
+	chunk.endDistance = m_chunks[from].endDistance;
+}
+
+void CTrackMesh::UpdateBlockBounds(unsigned int block, float startDistance, float endDistance)
+{
+	const TrackVertex *pVertices = GetBlockVertices(block);
+	TrackChunk &chunk = m_chunks[block];
+	chunk.startDistance = startDistance;
+	chunk.endDistance = endDistance;
+	chunk.boundsMin = chunk.boundsMax = pVertices[0].position;
+	for (unsigned int v = 1; v < GetBlockVertexCount(); v++) {
+		chunk.boundsMin = glm::min(chunk.boundsMin, pVertices[v].position);
+		chunk.boundsMax = glm::max(chunk.boundsMax, pVertices[v].position);
+	}
+}
+
+void CTrackMesh::FindVisibleChunks(const CFrustum &frustum, const glm::vec3 &eye, vector<TrackChunkDraw> &visible) const
+{
+	visible.clear();
+	for (unsigned int c = 0; c < m_chunks.size(); c++) {
+		const TrackChunk &chunk = m_chunks[c];
+		if (!frustum.ContainsBox(chunk.boundsMin, chunk.boundsMax))
+			continue;
+
+		// Distance from the eye to the nearest point of the box (zero inside it)
+		float fDistance = glm::distance(eye, glm::clamp(eye, chunk.boundsMin, chunk.boundsMax));
+
+		TrackChunkDraw draw;
+		draw.chunk = c;
+		draw.lod = fDistance < m_lod1Distance ? 0 : (fDistance < m_lod2Distance ? 1 : 2);
+		visible.push_back(draw);
+	}
+}
+
+const TrackVertex *CTrackMesh::GetVertexData() const
+{
+	return m_pVertices;
+}
+
+unsigned int CTrackMesh::GetVertexCount() const
+{
+	return m_numVertices;
+}
+
+const void *CTrackMesh::GetIndexData() const
+{
+	return m_pIndices;
+}
+
+unsigned int CTrackMesh::GetIndexCount() const
+{
+	return m_numIndices;
+}
+
+unsigned int CTrackMesh::GetIndexSize() const
+{
+	return m_indexSize;
+}
+
+GLenum CTrackMesh::GetIndexType() const
+{
+	return m_indexSize == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+void CTrackMesh::SetLodDistances(float fLod1Distance, float fLod2Distance)
+{
+	m_lod1Distance = fLod1Distance;
+	m_lod2Distance = fLod2Distance;
+}
+
+const vector<TrackChunk> &CTrackMesh::GetChunks() const
+{
+	return m_chunks;
+}
+
+unsigned int CTrackMesh::GetFullDetailIndexCount() const
+{
+	return m_fullDetailIndexCount;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Common.h"
+
+struct TrackFrame;
+class CFrustum;
+
+// Interleaved track vertex, laid out to match the position / texture coordinate / normal attributes (locations 0, 1, 2) of mainShader
+struct TrackVertex
+{
+	glm::vec3 position;
+	glm::vec2 texCoord;
+	glm::vec3 normal;
+};
+
+// A fixed length piece of the track.  Each level of detail is a separate index range; level l keeps every (1 << l)th centreline 
+// sample, plus the samples at the ends of the chunk, so neighbouring chunks always meet along the same edge.
+struct TrackChunk
+{
+	static const int NUM_LODS = 3;
+
+	unsigned int firstIndex[NUM_LODS];	// Offset of the first index of each level, in indices
+	unsigned int indexCount[NUM_LODS];
+	glm::vec3 boundsMin, boundsMax;		// Axis aligned bounding box
+	float startDistance, endDistance;	// Extent along the centreline
+};
+
+// A chunk to draw, and at which level of detail
+struct TrackChunkDraw
+{
+	int chunk;
+	int lod;
+};
+
+// Builds the road surface between the left and right offset curves as an indexed triangle list.  Each centreline sample contributes 
+// one left and one right vertex that are shared by the quads either side of it, with one extra pair at the end of the lap so the 
+// texture wraps continuously back onto the start.  The track is cut into chunks of about the same length, each with its own bounds 
+// and levels of detail, so that only what is in view needs to be drawn.  Indices are 16 bit whenever the vertex count allows.  
+// Nothing here makes GL calls, so the mesh can be generated and checked without a context.
+class CTrackMesh
+{
+public:
+	CTrackMesh();
+	~CTrackMesh();
+
+	// left, right, distances and frames have one entry per centreline sample around a closed loop of length fTotalLength.  The 
+	// texture repeats every fTextureLength along the track and spans the width once.  Chunks start every fChunkLength.
+	void Build(const vector<glm::vec3> &left, const vector<glm::vec3> &right, const vector<float> &distances, 
+		const vector<TrackFrame> &frames, float fTotalLength, float fTextureLength, float fChunkLength);
+	void Clear();
+
+	// Use vertex and index data held elsewhere (such as a memory mapped track cache) instead of building it.  The data must stay 
+	// valid until the mesh is cleared or rebuilt; the chunks are copied.
+	void Attach(const TrackVertex *pVertices, unsigned int numVertices, const void *pIndices, unsigned int numIndices, unsigned int indexSize, 
+		const TrackChunk *pChunks, unsigned int numChunks, unsigned int fullDetailIndexCount);
+
+	// Block layout, for editing: one block per spline segment, each with its own samplesPerBlock + 1 vertex pairs (the last pair 
+	// repeats the first pair of the next segment) and used as a chunk.  The caller fills in the vertices of each block, so blocks can 
+	// be rewritten, added and removed individually.  Storage for capacity blocks is allocated up front, and the indices only change 
+	// when that has to grow.
+	void BuildBlocks(unsigned int numBlocks, unsigned int capacity, unsigned int samplesPerBlock);
+	bool SetNumBlocks(unsigned int numBlocks);		// Returns true if the storage had to grow, in which case all of it has changed
+	unsigned int GetNumBlocks() const;
+	unsigned int GetBlockVertexCount() const;		// Vertices per block, 2 * (samplesPerBlock + 1)
+	TrackVertex *GetBlockVertices(unsigned int block);
+	void CopyBlock(unsigned int from, unsigned int to);
+	void UpdateBlockBounds(unsigned int block, float startDistance, float endDistance);	// After its vertices have been written
+
+	// Chunks that intersect the frustum, each at a level of detail chosen by the distance of its bounding box from the eye: level 0 
+	// up to SetLodDistances' fLod1Distance, level 1 up to fLod2Distance, level 2 beyond.
+	void FindVisibleChunks(const CFrustum &frustum, const glm::vec3 &eye, vector<TrackChunkDraw> &visible) const;
+	void SetLodDistances(float fLod1Distance, float fLod2Distance);
+
+	const vector<TrackChunk> &GetChunks() const;
+
+	const TrackVertex *GetVertexData() const;
+	unsigned int GetVertexCount() const;
+	const void *GetIndexData() const;		// Pointer to the first index, in the format given by GetIndexType
+	unsigned int GetIndexCount() const;
+	unsigned int GetIndexSize() const;		// Bytes per index, 2 or 4
+	GLenum GetIndexType() const;			// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int GetFullDetailIndexCount() const;	// The level 0 ranges of all the chunks are contiguous from index 0 and cover the whole track
+
+private:
+	// Chunk c spans the vertex pairs chunkStarts[c] to chunkEnds[c]
+	template <typename T> void BuildIndices(vector<T> &indices, const vector<unsigned int> &chunkStarts, const vector<unsigned int> &chunkEnds, 
+		vector<TrackChunk> &chunks);
+	void BuildBlockIndices();
+
+	vector<TrackVertex> m_vertices;
+
+	// The mesh in use: either the vectors above, or attached data
+	const TrackVertex *m_pVertices;
+	unsigned int m_numVertices;
+	const void *m_pIndices;
+	unsigned int m_numIndices;
+	unsigned int m_indexSize;
+
+	vector<TrackChunk> m_chunks;
+	unsigned int m_fullDetailIndexCount;
+	float m_lod1Distance;
+	float m_lod2Distance;
+	vector<unsigned short> m_indices16;		// Used if m_vertices.size() <= 65536
+	vector<unsigned int> m_indices32;		// Used otherwise
+
+	// Block layout; m_samplesPerBlock is 0 if the mesh was built by Build
+	unsigned int m_samplesPerBlock;
+	unsigned int m_blockCapacity;
+	unsigned int m_blockFirstIndex[TrackChunk::NUM_LODS];	// Block b's range at level l starts at m_blockFirstIndex[l] + b * m_blockIndexCount[l]
+	unsigned int m_blockIndexCount[TrackChunk::NUM_LODS];
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+// Hands a value from one producer thread to one consumer thread without locks.  Of the three copies, the producer writes one, the 
+// consumer reads another, and the third holds the latest finished value between them; Publish and Acquire each swap their own 
+// copy with that one in a single atomic exchange.  Neither side ever waits for the other: the producer can publish as often as it 
+// likes (values the consumer never took are overwritten), and the consumer keeps reading its copy until it acquires a newer one.  
+// Buffers are reused, so a T holding vectors stops allocating once they have grown to size.
+template <typename T> class CTripleBuffer
+{
+public:
+	CTripleBuffer() : m_middle(1), m_back(0), m_front(2) {}
+
+	// Producer side: fill in the write buffer, then publish it
+	T &GetWriteBuffer() { return m_buffers[m_back]; }
+	void Publish()
+	{
+		m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Consumer side: take the latest published value, if there is one newer than the read buffer
+	bool Acquire()
+	{
+		if ((m_middle.load(std::memory_order_acquire) & FRESH) == 0)
+			return false;
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	const T &GetReadBuffer() const { return m_buffers[m_front]; }
+
+private:
+	CTripleBuffer(const CTripleBuffer&);
+	void operator=(const CTripleBuffer&);
+
+	enum { INDEX = 3, FRESH = 4 };	// m_middle holds a buffer index, and FRESH if the producer has published it since it was taken
+
+	T m_buffers[3];
+	std::atomic<int> m_middle;
+	int m_back;			// Only touched by the producer
+	int m_front;		// Only touched by the consumer
+};